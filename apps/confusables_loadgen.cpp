@@ -0,0 +1,192 @@
+#include "unicode_confusables_client.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string socket_path;
+    size_t connections = 4;
+    size_t depth = 32;
+    size_t requests = 100000;
+    unicode_confusables::protocol::Operation operation = unicode_confusables::protocol::Operation::NORMALIZE_CONFUSABLES;
+    uint8_t flags = 0;
+    std::vector<std::string> payloads;
+};
+
+struct Result {
+    bool ok = true;
+    std::string error;
+    std::vector<double> latencies_us;
+};
+
+// Keeps up to depth requests outstanding on one connection until count have been answered
+void run_connection(const Options& options, size_t count, size_t first_payload, Result& result) {
+    unicode_confusables::NormalizationClient client;
+    if (!client.connect(options.socket_path)) {
+        result.ok = false;
+        result.error = client.error();
+        return;
+    }
+    result.latencies_us.reserve(count);
+    std::deque<Clock::time_point> sent_at;
+    size_t sent = 0;
+    unicode_confusables::protocol::Response response;
+    while (result.latencies_us.size() < count) {
+        while (sent < count && sent_at.size() < options.depth) {
+            client.send(options.operation, options.flags, options.payloads[(first_payload + sent) % options.payloads.size()]);
+            sent_at.push_back(Clock::now());
+            ++sent;
+        }
+        if (!client.receive(response)) {
+            result.ok = false;
+            result.error = client.error();
+            return;
+        }
+        if (response.status != unicode_confusables::protocol::Status::OK) {
+            result.ok = false;
+            result.error = "server returned status " + std::to_string(static_cast<int>(response.status));
+            return;
+        }
+        // Responses come in request order
+        result.latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent_at.front()).count());
+        sent_at.pop_front();
+    }
+}
+
+bool parse_count(const char* text, size_t& value) {
+    std::string s = text;
+    if (s.empty() || s.size() > 12 || s.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    value = std::stoull(s);
+    return value > 0;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::string input_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << "Usage: " << argv[0] << " --socket PATH [options]\n";
+            std::cout << "Sends pipelined requests to a confusables_normalize --serve daemon and reports throughput\n";
+            std::cout << "and latency.\n\n";
+            std::cout << "Options:\n";
+            std::cout << "  --socket PATH           Socket of the daemon (required)\n";
+            std::cout << "  --connections N         Concurrent connections, one thread each (default: 4)\n";
+            std::cout << "  --depth N               Requests outstanding per connection (default: 32)\n";
+            std::cout << "  --requests N            Total requests (default: 100000)\n";
+            std::cout << "  --op OP                 normalize, contains or ping (default: normalize)\n";
+            std::cout << "  --fold-case             Set the fold-case flag on normalize requests\n";
+            std::cout << "  --input FILE            Use the lines of FILE as payloads (default: built-in samples)\n";
+            return 0;
+        }
+        if (i + 1 >= argc && arg != "--fold-case") {
+            std::cerr << "Error: " << arg << " requires a value\n";
+            return 1;
+        }
+        if (arg == "--socket") {
+            options.socket_path = argv[++i];
+        } else if (arg == "--connections" || arg == "--depth" || arg == "--requests") {
+            size_t& value = arg == "--connections" ? options.connections : arg == "--depth" ? options.depth : options.requests;
+            if (!parse_count(argv[++i], value)) {
+                std::cerr << "Error: " << arg << " requires a positive number\n";
+                return 1;
+            }
+        } else if (arg == "--op") {
+            std::string op = argv[++i];
+            if (op == "normalize") {
+                options.operation = unicode_confusables::protocol::Operation::NORMALIZE_CONFUSABLES;
+            } else if (op == "contains") {
+                options.operation = unicode_confusables::protocol::Operation::CONTAINS_CONFUSABLES;
+            } else if (op == "ping") {
+                options.operation = unicode_confusables::protocol::Operation::PING;
+            } else {
+                std::cerr << "Error: Invalid operation '" << op << "'\n";
+                return 1;
+            }
+        } else if (arg == "--fold-case") {
+            options.flags |= unicode_confusables::protocol::FLAG_FOLD_CASE;
+        } else if (arg == "--input") {
+            input_path = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            std::cerr << "Use --help for usage information.\n";
+            return 1;
+        }
+    }
+    if (options.socket_path.empty()) {
+        std::cerr << "Error: --socket is required\n";
+        return 1;
+    }
+    if (options.operation != unicode_confusables::protocol::Operation::NORMALIZE_CONFUSABLES) {
+        options.flags = 0;
+    }
+
+    if (!input_path.empty()) {
+        std::ifstream input(input_path);
+        if (!input) {
+            std::cerr << "Error: cannot open " << input_path << "\n";
+            return 1;
+        }
+        std::string line;
+        while (std::getline(input, line)) {
+            options.payloads.push_back(line);
+        }
+    }
+    if (options.payloads.empty()) {
+        options.payloads = {"Hello World", "Неllо Wоrld", "PАYPАL.com", "𝐇𝐞𝐥𝐥𝐨 𝐖𝐨𝐫𝐥𝐝",
+                            "user@exаmple.com", "The quick brown fox jumps over the lazy dog",
+                            "ＡＢＣ　ｆｕｌｌｗｉｄｔｈ", "ℌ𝔢𝔩𝔩𝔬 ᏔᎾᏒᏞᎠ"};
+    }
+
+    // Split the requests over the connections
+    std::vector<Result> results(options.connections);
+    std::vector<std::thread> threads;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < options.connections; ++i) {
+        size_t count = options.requests / options.connections + (i < options.requests % options.connections ? 1 : 0);
+        threads.emplace_back(run_connection, std::cref(options), count, i, std::ref(results[i]));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    for (const auto& result : results) {
+        if (!result.ok) {
+            std::cerr << "Error: " << result.error << "\n";
+            return 1;
+        }
+        latencies.insert(latencies.end(), result.latencies_us.begin(), result.latencies_us.end());
+    }
+    if (latencies.empty()) {
+        std::cerr << "Error: no requests completed\n";
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "requests:    " << latencies.size() << " over " << options.connections << " connections, depth "
+              << options.depth << "\n";
+    std::cout << "elapsed:     " << seconds << " s\n";
+    std::cout << "throughput:  " << static_cast<double>(latencies.size()) / seconds << " req/s\n";
+    std::cout << "latency us:  p50 " << percentile(latencies, 0.50) << ", p90 " << percentile(latencies, 0.90) << ", p99 "
+              << percentile(latencies, 0.99) << ", max " << latencies.back() << "\n";
+    return 0;
+}
@@ -1,6 +1,84 @@
 #include "unicode_confusables.h"
+#include "unicode_confusables_records.h"
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+#include "unicode_confusables_server.h"
+#include <csignal>
+#endif
 #include <iostream>
 #include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    size_t pos = 0;
+    for (;;) {
+        size_t comma = list.find(',', pos);
+        std::string item = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+        if (comma == std::string::npos) {
+            return items;
+        }
+        pos = comma + 1;
+    }
+}
+
+// Prints the --check verdict for one line or record; returns true if confusables were found
+bool report_confusables(const std::unordered_set<std::string>& confusables) {
+    if (confusables.empty()) {
+        std::cout << "CLEAN\n";
+        return false;
+    }
+    std::cout << "CONFUSABLES_DETECTED: ";
+    bool first = true;
+    for (const auto& confusable : confusables) {
+        if (!first) std::cout << ", ";
+        std::cout << "'" << confusable << "'";
+        first = false;
+    }
+    std::cout << "\n";
+    return true;
+}
+
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+unicode_confusables::NormalizationServer* active_server = nullptr;
+
+void stop_server(int) {
+    if (active_server) {
+        active_server->stop();
+    }
+}
+
+int serve(const std::string& socket_path, size_t threads, unsigned socket_mode) {
+    unicode_confusables::ServerOptions options;
+    options.worker_threads = threads;
+    options.socket_mode = socket_mode;
+    unicode_confusables::NormalizationServer server(options);
+    if (!server.listen(socket_path)) {
+        std::cerr << "Error: " << server.error() << "\n";
+        return 1;
+    }
+    active_server = &server;
+    struct sigaction action{};
+    action.sa_handler = stop_server;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    std::cerr << "Serving on " << socket_path << "\n";
+    bool ok = server.run();
+    active_server = nullptr;
+    if (!ok) {
+        std::cerr << "Error: " << server.error() << "\n";
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+} // namespace
 
 int main(int argc, char* argv[]) {
     // Check for help flag
@@ -10,25 +88,51 @@ int main(int argc, char* argv[]) {
         std::cout << "Options:\n";
         std::cout << "  --help, -h              Show this help message\n";
         std::cout << "  --check, -c             Only check if input contains confusables (exit code 0=clean, 1=contains confusables)\n";
+        std::cout << "  --fold-case, -f         Case fold the output along with confusables normalization\n";
         std::cout << "  --normalize, -n TYPE    Apply Unicode normalization before confusables normalization\n";
         std::cout << "                          TYPE can be: nfc, nfd, nfkc, nfkd, none (default: none)\n";
+        std::cout << "  --format FORMAT         Input format: text, jsonl, csv, tsv (default: text)\n";
+        std::cout << "                          text processes every line as a whole; the record formats only touch\n";
+        std::cout << "                          string fields and copy keys, numbers and separators unchanged.\n";
+        std::cout << "                          csv and tsv input starts with a header line naming the columns.\n";
+        std::cout << "  --fields LIST           Comma-separated JSON keys or column names to process (default: all)\n";
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+        std::cout << "  --serve PATH            Run as a daemon answering requests on the Unix socket PATH instead of\n";
+        std::cout << "                          reading stdin (protocol: unicode_confusables_protocol.h)\n";
+        std::cout << "  --threads N             Worker threads for --serve (default: one per CPU)\n";
+        std::cout << "  --socket-mode MODE      Octal permissions of the --serve socket (default: 600, owner only)\n";
+#endif
         std::cout << "\nExamples:\n";
         std::cout << "  echo 'Hello Wοrld' | " << argv[0] << "\n";
         std::cout << "  echo 'café' | " << argv[0] << " --normalize nfd\n";
         std::cout << "  echo 'café' | " << argv[0] << " -n nfkd\n";
         std::cout << "  echo 'ﬁle' | " << argv[0] << " --normalize nfkc\n";
+        std::cout << "  echo 'PАYPАL' | " << argv[0] << " --fold-case\n";
         std::cout << "  echo 'suspicious text' | " << argv[0] << " --check\n";
+        std::cout << "  " << argv[0] << " --format jsonl --fields name,bio < users.jsonl\n";
+        std::cout << "  " << argv[0] << " --format csv --fields name --check < users.csv\n";
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+        std::cout << "  " << argv[0] << " --serve /tmp/confusables.sock --threads 4\n";
+#endif
         return 0;
     }
 
     bool check_only = false;
+    bool fold_case = false;
     std::string normalization_type = "none";
+    std::string format = "text";
+    std::vector<std::string> fields;
+    std::string serve_path;
+    size_t threads = 0;
+    unsigned socket_mode = 0600;
 
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--check" || arg == "-c") {
             check_only = true;
+        } else if (arg == "--fold-case" || arg == "-f") {
+            fold_case = true;
         } else if (arg == "--normalize" || arg == "-n") {
             // Check if there's a next argument for the normalization type
             if (i + 1 >= argc) {
@@ -44,6 +148,58 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Valid types are: nfc, nfd, nfkc, nfkd, none\n";
                 return 1;
             }
+        } else if (arg == "--format") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --format requires a format (text, jsonl, csv, or tsv)\n";
+                std::cerr << "Use --help for usage information.\n";
+                return 1;
+            }
+            format = argv[++i];
+            if (format != "text" && format != "jsonl" && format != "csv" && format != "tsv") {
+                std::cerr << "Error: Invalid format '" << format << "'\n";
+                std::cerr << "Valid formats are: text, jsonl, csv, tsv\n";
+                return 1;
+            }
+        } else if (arg == "--fields") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --fields requires a comma-separated list of field names\n";
+                std::cerr << "Use --help for usage information.\n";
+                return 1;
+            }
+            fields = split_list(argv[++i]);
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+        } else if (arg == "--serve") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --serve requires a socket path\n";
+                std::cerr << "Use --help for usage information.\n";
+                return 1;
+            }
+            serve_path = argv[++i];
+        } else if (arg == "--threads") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --threads requires a number\n";
+                std::cerr << "Use --help for usage information.\n";
+                return 1;
+            }
+            std::string count = argv[++i];
+            if (count.empty() || count.size() > 4 || count.find_first_not_of("0123456789") != std::string::npos) {
+                std::cerr << "Error: Invalid thread count '" << count << "'\n";
+                return 1;
+            }
+            threads = std::stoul(count);
+        } else if (arg == "--socket-mode") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --socket-mode requires an octal mode such as 660\n";
+                std::cerr << "Use --help for usage information.\n";
+                return 1;
+            }
+            std::string mode = argv[++i];
+            if (mode.empty() || mode.size() > 4 || mode.find_first_not_of("01234567") != std::string::npos) {
+                std::cerr << "Error: Invalid socket mode '" << mode << "'\n";
+                return 1;
+            }
+            socket_mode = static_cast<unsigned>(std::stoul(mode, nullptr, 8));
+#endif
         } else {
             std::cerr << "Unknown option: " << arg << "\n";
             std::cerr << "Use --help for usage information.\n";
@@ -51,44 +207,136 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (!fields.empty() && format == "text") {
+        std::cerr << "Error: --fields requires --format jsonl, csv, or tsv\n";
+        return 1;
+    }
+
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+    if (!serve_path.empty()) {
+        // Each request carries its own operation and flags
+        if (check_only || fold_case || normalization_type != "none" || format != "text" || !fields.empty()) {
+            std::cerr << "Error: --serve cannot be combined with processing options; requests choose them\n";
+            return 1;
+        }
+        return serve(serve_path, threads, socket_mode);
+    }
+#endif
+
+    bool unicode_normalization = normalization_type != "none";
+    unicode_confusables::NormalizationType norm_type = unicode_confusables::NormalizationType::NFC;
+    if (normalization_type == "nfd") {
+        norm_type = unicode_confusables::NormalizationType::NFD;
+    } else if (normalization_type == "nfkc") {
+        norm_type = unicode_confusables::NormalizationType::NFKC;
+    } else if (normalization_type == "nfkd") {
+        norm_type = unicode_confusables::NormalizationType::NFKD;
+    }
+
     std::string line;
     int exit_code = 0;
 
+    if (format != "text") {
+        unicode_confusables::RecordFormat record_format = format == "jsonl" ? unicode_confusables::RecordFormat::JSONL
+                                                        : format == "csv"   ? unicode_confusables::RecordFormat::CSV
+                                                                            : unicode_confusables::RecordFormat::TSV;
+        unicode_confusables::RecordFieldRewriter rewriter(record_format, fields);
+        // Same pipeline as text mode, applied to each selected field value
+        auto transform = [&](std::string_view value, std::string& out) {
+            if (unicode_normalization) {
+                out = unicode_confusables::normalize_confusables(
+                    unicode_confusables::unicode_normalize(value, norm_type, true), fold_case);
+            } else {
+                out = unicode_confusables::normalize_confusables(value, fold_case);
+            }
+        };
+        std::string record;
+        std::string output;
+        size_t line_number = 0;
+        size_t record_line = 0;
+        bool pending = false;
+        for (;;) {
+            if (std::getline(std::cin, line)) {
+                ++line_number;
+                // A quoted CSV field may span lines: gather the whole record first
+                if (!pending) {
+                    record_line = line_number;
+                    record.swap(line);
+                    pending = true;
+                } else {
+                    record += '\n';
+                    record += line;
+                }
+                if (!rewriter.record_complete(record)) {
+                    continue;
+                }
+            } else if (!pending) {
+                break;
+            }
+            // Complete, or cut short by the end of input (then reported as malformed)
+            pending = false;
+            if (rewriter.expects_header()) {
+                if (!rewriter.read_header(record)) {
+                    std::cerr << "Error: malformed " << format << " header on line " << record_line << "\n";
+                    return 1;
+                }
+                for (const auto& missing : rewriter.missing_fields()) {
+                    std::cerr << "Warning: field '" << missing << "' is not in the header\n";
+                }
+                if (!check_only) {
+                    output += record;
+                    output += '\n';
+                }
+            } else if (check_only) {
+                std::unordered_set<std::string> confusables;
+                bool ok = rewriter.visit(record, [&](std::string_view value) {
+                    confusables.merge(unicode_confusables::contains_confusables(value));
+                });
+                if (!ok) {
+                    std::cerr << "Warning: malformed " << format << " record on line " << record_line << "\n";
+                }
+                if (report_confusables(confusables)) {
+                    exit_code = 1;
+                }
+            } else {
+                if (!rewriter.rewrite(record, transform, output)) {
+                    std::cerr << "Warning: malformed " << format << " record on line " << record_line
+                              << ", copied unchanged\n";
+                }
+                output += '\n';
+            }
+            record.clear();
+            // Write in large blocks rather than per record
+            if (output.size() >= (1 << 16)) {
+                std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+                output.clear();
+            }
+        }
+        std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+        return exit_code;
+    }
+
     // Read input line by line
     while (std::getline(std::cin, line)) {
         if (check_only) {
             // Just check for confusables
-            auto confusables = unicode_confusables::contains_confusables(line);
-            if (!confusables.empty()) {
-                std::cout << "CONFUSABLES_DETECTED: ";
-                bool first = true;
-                for (const auto& confusable : confusables) {
-                    if (!first) std::cout << ", ";
-                    std::cout << "'" << confusable << "'";
-                    first = false;
-                }
-                std::cout << "\n";
+            if (report_confusables(unicode_confusables::contains_confusables(line))) {
                 exit_code = 1;
-            } else {
-                std::cout << "CLEAN\n";
             }
         } else {
-            if (normalization_type != "none") {
+            if (unicode_normalization) {
                 // Apply Unicode normalization
-                unicode_confusables::NormalizationType norm_type;
-                if (normalization_type == "nfc") {
-                    norm_type = unicode_confusables::NormalizationType::NFC;
-                } else if (normalization_type == "nfd") {
-                    norm_type = unicode_confusables::NormalizationType::NFD;
-                } else if (normalization_type == "nfkc") {
-                    norm_type = unicode_confusables::NormalizationType::NFKC;
-                } else if (normalization_type == "nfkd") {
-                    norm_type = unicode_confusables::NormalizationType::NFKD;
-                }
                 line = unicode_confusables::unicode_normalize(line, norm_type, true);
             }
-            // Apply confusables normalization (default)
-            line = unicode_confusables::normalize_confusables(line);
+            // Apply confusables normalization (default), in place in the line buffer when no replacement grows
+            size_t len = line.size();
+            size_t resume = 0;
+            bool complete = unicode_confusables::normalize_confusables_inplace(&line[0], len, resume, fold_case);
+            line.resize(len);
+            if (!complete) {
+                std::string rest = unicode_confusables::normalize_confusables(std::string_view(line).substr(resume), fold_case);
+                line.replace(resume, std::string::npos, rest);
+            }
             std::cout << line << "\n";
         }
     }
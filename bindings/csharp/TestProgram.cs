@@ -1,4 +1,5 @@
 using System;
+using System.Text;
 using UnicodeConfusables;
 
 class Program
@@ -38,6 +39,21 @@ class Program
             Console.WriteLine($"Error normalizing confusables: {ex.Message}");
         }
 
+        // Test span-based normalization into a stack buffer
+        try
+        {
+            ReadOnlySpan<byte> utf8Input = Encoding.UTF8.GetBytes(testInput);
+            Span<byte> utf8Output = stackalloc byte[ConfusablesDetector.GetMaxNormalizedLength(utf8Input.Length)];
+            if (ConfusablesDetector.TryNormalizeConfusables(utf8Input, utf8Output, out int bytesWritten))
+            {
+                Console.WriteLine($"Span Normalized: {Encoding.UTF8.GetString(utf8Output.Slice(0, bytesWritten))}");
+            }
+        }
+        catch (Exception ex)
+        {
+            Console.WriteLine($"Error with span normalization: {ex.Message}");
+        }
+
         // Test unicode_normalize_kd
         try
         {
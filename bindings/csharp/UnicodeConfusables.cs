@@ -1,4 +1,5 @@
 using System;
+using System.Buffers;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
 using System.Text;
@@ -27,26 +28,34 @@ namespace UnicodeConfusables
     {
         private const string LibraryName = "unicode_confusables_csharp";
 
+        // Outputs up to this many code units use stackalloc; larger ones rent from ArrayPool
+        private const int StackallocThreshold = 512;
+
+        // Blittable (byte*, length) signatures: no marshalling stubs, no native allocations to free.
         [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern IntPtr unicode_confusables_contains_confusables([MarshalAs(UnmanagedType.LPUTF8Str)] string input);
+        private static extern unsafe int unicode_confusables_normalize_confusables_utf8(byte* input, int inputLength, byte* output, int outputCapacity, int foldCase);
 
         [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern void unicode_confusables_free_set(IntPtr handle);
+        private static extern unsafe int unicode_confusables_unicode_normalize_utf8(byte* input, int inputLength, int type, int stripZeroWidth, byte* output, int outputCapacity);
 
         [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern int unicode_confusables_set_size(IntPtr handle);
+        private static extern unsafe int unicode_confusables_contains_confusables_utf8(byte* input, int inputLength, byte* output, int outputCapacity);
 
+        // UTF-16 entry points take .NET strings as they are, without transcoding to UTF-8 and back
         [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern IntPtr unicode_confusables_set_get(IntPtr handle, int index);
+        private static extern unsafe int unicode_confusables_normalize_confusables_utf16(char* input, int inputLength, char* output, int outputCapacity, int foldCase);
 
         [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern IntPtr unicode_confusables_normalize_confusables([MarshalAs(UnmanagedType.LPUTF8Str)] string input);
+        private static extern unsafe int unicode_confusables_unicode_normalize_utf16(char* input, int inputLength, int type, int stripZeroWidth, char* output, int outputCapacity);
 
         [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern IntPtr unicode_confusables_unicode_normalize([MarshalAs(UnmanagedType.LPUTF8Str)] string input, int type, int stripZeroWidth);
+        private static extern unsafe int unicode_confusables_contains_confusables_utf16(char* input, int inputLength, char* output, int outputCapacity);
 
+        // Pure arithmetic on the native side, so the GC transition can be skipped.
+        // The other entry points scale with input size and stay on the normal transition.
         [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern void unicode_confusables_free_string(IntPtr str);
+        [SuppressGCTransition]
+        private static extern int unicode_confusables_normalize_confusables_max_length(int inputLength);
 
         /// <summary>
         /// Returns the set of confusable Unicode characters found in the input string.
@@ -54,64 +63,143 @@ namespace UnicodeConfusables
         /// <param name="input">The input string to analyze</param>
         /// <returns>A hash set containing the confusable characters found</returns>
         /// <exception cref="ArgumentNullException">Thrown when input is null</exception>
-        public static HashSet<string> ContainsConfusables(string input)
+        public static unsafe HashSet<string> ContainsConfusables(string input)
         {
             if (input == null)
                 throw new ArgumentNullException(nameof(input));
 
             var result = new HashSet<string>();
-            IntPtr handle = unicode_confusables_contains_confusables(input);
-            
-            if (handle == IntPtr.Zero)
-                return result;
 
+            // The distinct confusables are a subset of the input's characters, so the input length always suffices
+            char[] rented = null;
+            Span<char> output = input.Length <= StackallocThreshold
+                ? stackalloc char[StackallocThreshold]
+                : (rented = ArrayPool<char>.Shared.Rent(input.Length));
             try
             {
-                int size = unicode_confusables_set_size(handle);
-                for (int i = 0; i < size; i++)
+                int written;
+                fixed (char* inputPtr = input)
+                fixed (char* outputPtr = output)
+                {
+                    written = unicode_confusables_contains_confusables_utf16(inputPtr, input.Length, outputPtr, output.Length);
+                }
+                if (written < 0 || written > output.Length)
+                    return result;
+
+                // Each confusable is a single codepoint (one char or a surrogate pair), written back to back
+                ReadOnlySpan<char> remaining = output.Slice(0, written);
+                while (!remaining.IsEmpty)
                 {
-                    IntPtr itemPtr = unicode_confusables_set_get(handle, i);
-                    if (itemPtr != IntPtr.Zero)
-                    {
-                        string item = Marshal.PtrToStringUTF8(itemPtr);
-                        if (item != null)
-                        {
-                            result.Add(item);
-                        }
-                    }
+                    int length = char.IsHighSurrogate(remaining[0]) && remaining.Length > 1 ? 2 : 1;
+                    result.Add(new string(remaining.Slice(0, length)));
+                    remaining = remaining.Slice(length);
                 }
+                return result;
             }
             finally
             {
-                unicode_confusables_free_set(handle);
+                if (rented != null)
+                    ArrayPool<char>.Shared.Return(rented);
             }
+        }
 
-            return result;
+        /// <summary>
+        /// Returns the set of confusable Unicode characters found in UTF-8 encoded input.
+        /// </summary>
+        /// <param name="utf8Input">The UTF-8 input to analyze</param>
+        /// <returns>A hash set containing the confusable characters found</returns>
+        public static unsafe HashSet<string> ContainsConfusables(ReadOnlySpan<byte> utf8Input)
+        {
+            var result = new HashSet<string>();
+
+            // The distinct confusables are a subset of the input's characters, so the input length always suffices
+            byte[] rented = null;
+            Span<byte> output = utf8Input.Length <= StackallocThreshold
+                ? stackalloc byte[StackallocThreshold]
+                : (rented = ArrayPool<byte>.Shared.Rent(utf8Input.Length));
+            try
+            {
+                int written;
+                fixed (byte* inputPtr = utf8Input)
+                fixed (byte* outputPtr = output)
+                {
+                    written = unicode_confusables_contains_confusables_utf8(inputPtr, utf8Input.Length, outputPtr, output.Length);
+                }
+                if (written < 0 || written > output.Length)
+                    return result;
+
+                // Each confusable is a single codepoint, written back to back
+                ReadOnlySpan<byte> remaining = output.Slice(0, written);
+                while (!remaining.IsEmpty)
+                {
+                    Rune.DecodeFromUtf8(remaining, out Rune rune, out int consumed);
+                    result.Add(rune.ToString());
+                    remaining = remaining.Slice(consumed);
+                }
+                return result;
+            }
+            finally
+            {
+                if (rented != null)
+                    ArrayPool<byte>.Shared.Return(rented);
+            }
         }
 
         /// <summary>
         /// Returns a new string with confusable characters replaced by their canonical equivalents.
         /// </summary>
         /// <param name="input">The input string to normalize</param>
+        /// <param name="foldCase">If true, the result is also case folded</param>
         /// <returns>A normalized string with confusables replaced</returns>
         /// <exception cref="ArgumentNullException">Thrown when input is null</exception>
-        public static string NormalizeConfusables(string input)
+        public static string NormalizeConfusables(string input, bool foldCase = false)
         {
             if (input == null)
                 throw new ArgumentNullException(nameof(input));
 
-            IntPtr resultPtr = unicode_confusables_normalize_confusables(input);
-            if (resultPtr == IntPtr.Zero)
-                return input; // Return original string if normalization fails
+            // Most mappings keep or shrink the UTF-16 length; TransformToString grows once if needed
+            return TransformToString(input.AsSpan(), input.Length, new ConfusablesTransform(foldCase)) ?? input; // Return original string if normalization fails
+        }
 
-            try
-            {
-                return Marshal.PtrToStringUTF8(resultPtr) ?? input;
-            }
-            finally
-            {
-                unicode_confusables_free_string(resultPtr);
-            }
+        /// <summary>
+        /// Returns a new string with confusable characters in UTF-8 encoded input replaced by their canonical equivalents.
+        /// </summary>
+        /// <param name="utf8Input">The UTF-8 input to normalize</param>
+        /// <param name="foldCase">If true, the result is also case folded</param>
+        /// <returns>A normalized string with confusables replaced, or null if normalization fails</returns>
+        public static string NormalizeConfusables(ReadOnlySpan<byte> utf8Input, bool foldCase = false)
+        {
+            int maxLength = unicode_confusables_normalize_confusables_max_length(utf8Input.Length);
+            return TransformToString(utf8Input, maxLength < 0 ? utf8Input.Length : maxLength, new Utf8ConfusablesTransform(foldCase));
+        }
+
+        /// <summary>
+        /// Normalizes confusable characters from UTF-8 input into a caller-provided buffer without allocating.
+        /// </summary>
+        /// <param name="utf8Input">The UTF-8 input to normalize</param>
+        /// <param name="utf8Output">The buffer receiving the UTF-8 result; <see cref="GetMaxNormalizedLength"/> bytes always suffice</param>
+        /// <param name="bytesWritten">The number of bytes written to utf8Output, or 0 if it was too small</param>
+        /// <param name="foldCase">If true, the result is also case folded</param>
+        /// <returns>True if the full result was written, false if utf8Output was too small or normalization failed</returns>
+        public static unsafe bool TryNormalizeConfusables(ReadOnlySpan<byte> utf8Input, Span<byte> utf8Output, out int bytesWritten, bool foldCase = false)
+        {
+            int required = new Utf8ConfusablesTransform(foldCase).Run(utf8Input, utf8Output);
+            bytesWritten = required >= 0 && required <= utf8Output.Length ? required : 0;
+            return required >= 0 && required <= utf8Output.Length;
+        }
+
+        /// <summary>
+        /// Returns an upper bound on the UTF-8 size of normalized confusables output, suitable for sizing a stackalloc or pooled buffer.
+        /// </summary>
+        /// <param name="utf8InputLength">The UTF-8 input length in bytes</param>
+        /// <returns>The maximum number of bytes <see cref="TryNormalizeConfusables"/> can write</returns>
+        /// <exception cref="ArgumentOutOfRangeException">Thrown when the bound does not fit in an int</exception>
+        public static int GetMaxNormalizedLength(int utf8InputLength)
+        {
+            int maxLength = unicode_confusables_normalize_confusables_max_length(utf8InputLength);
+            if (maxLength < 0)
+                throw new ArgumentOutOfRangeException(nameof(utf8InputLength));
+            return maxLength;
         }
 
         /// <summary>
@@ -127,18 +215,23 @@ namespace UnicodeConfusables
             if (input == null)
                 throw new ArgumentNullException(nameof(input));
 
-            IntPtr resultPtr = unicode_confusables_unicode_normalize(input, (int)type, stripZeroWidth ? 1 : 0);
-            if (resultPtr == IntPtr.Zero)
-                return input; // Return original string if normalization fails
+            return TransformToString(input.AsSpan(), input.Length, new UnicodeNormalizeTransform(type, stripZeroWidth)) ?? input; // Return original string if normalization fails
+        }
 
-            try
-            {
-                return Marshal.PtrToStringUTF8(resultPtr) ?? input;
-            }
-            finally
-            {
-                unicode_confusables_free_string(resultPtr);
-            }
+        /// <summary>
+        /// Applies Unicode normalization to UTF-8 input, writing into a caller-provided buffer.
+        /// </summary>
+        /// <param name="utf8Input">The UTF-8 input to normalize</param>
+        /// <param name="utf8Output">The buffer receiving the UTF-8 result</param>
+        /// <param name="type">The type of normalization to apply</param>
+        /// <param name="bytesWritten">The number of bytes written to utf8Output, or 0 if it was too small</param>
+        /// <param name="stripZeroWidth">If true, zero-width characters are removed after normalization</param>
+        /// <returns>True if the full result was written, false if utf8Output was too small or normalization failed</returns>
+        public static bool TryUnicodeNormalize(ReadOnlySpan<byte> utf8Input, Span<byte> utf8Output, NormalizationType type, out int bytesWritten, bool stripZeroWidth = false)
+        {
+            int required = new Utf8UnicodeNormalizeTransform(type, stripZeroWidth).Run(utf8Input, utf8Output);
+            bytesWritten = required >= 0 && required <= utf8Output.Length ? required : 0;
+            return required >= 0 && required <= utf8Output.Length;
         }
 
         /// <summary>
@@ -153,5 +246,129 @@ namespace UnicodeConfusables
         {
             return UnicodeNormalize(input, NormalizationType.NFKD, stripZeroWidth);
         }
+
+        // A native call that writes its result in the input's encoding (UTF-8 bytes or UTF-16 chars) and returns
+        // the code units the full result needs (-1 on failure)
+        private interface ITextTransform<TUnit> where TUnit : unmanaged
+        {
+            int Run(ReadOnlySpan<TUnit> input, Span<TUnit> output);
+
+            string Decode(ReadOnlySpan<TUnit> output);
+        }
+
+        private readonly struct Utf8ConfusablesTransform : ITextTransform<byte>
+        {
+            private readonly int _foldCase;
+
+            public Utf8ConfusablesTransform(bool foldCase) => _foldCase = foldCase ? 1 : 0;
+
+            public unsafe int Run(ReadOnlySpan<byte> input, Span<byte> output)
+            {
+                fixed (byte* inputPtr = input)
+                fixed (byte* outputPtr = output)
+                {
+                    return unicode_confusables_normalize_confusables_utf8(inputPtr, input.Length, outputPtr, output.Length, _foldCase);
+                }
+            }
+
+            public string Decode(ReadOnlySpan<byte> output) => Encoding.UTF8.GetString(output);
+        }
+
+        private readonly struct ConfusablesTransform : ITextTransform<char>
+        {
+            private readonly int _foldCase;
+
+            public ConfusablesTransform(bool foldCase) => _foldCase = foldCase ? 1 : 0;
+
+            public unsafe int Run(ReadOnlySpan<char> input, Span<char> output)
+            {
+                fixed (char* inputPtr = input)
+                fixed (char* outputPtr = output)
+                {
+                    return unicode_confusables_normalize_confusables_utf16(inputPtr, input.Length, outputPtr, output.Length, _foldCase);
+                }
+            }
+
+            public string Decode(ReadOnlySpan<char> output) => new string(output);
+        }
+
+        private readonly struct Utf8UnicodeNormalizeTransform : ITextTransform<byte>
+        {
+            private readonly int _type;
+            private readonly int _stripZeroWidth;
+
+            public Utf8UnicodeNormalizeTransform(NormalizationType type, bool stripZeroWidth)
+            {
+                _type = (int)type;
+                _stripZeroWidth = stripZeroWidth ? 1 : 0;
+            }
+
+            public unsafe int Run(ReadOnlySpan<byte> input, Span<byte> output)
+            {
+                fixed (byte* inputPtr = input)
+                fixed (byte* outputPtr = output)
+                {
+                    return unicode_confusables_unicode_normalize_utf8(inputPtr, input.Length, _type, _stripZeroWidth, outputPtr, output.Length);
+                }
+            }
+
+            public string Decode(ReadOnlySpan<byte> output) => Encoding.UTF8.GetString(output);
+        }
+
+        private readonly struct UnicodeNormalizeTransform : ITextTransform<char>
+        {
+            private readonly int _type;
+            private readonly int _stripZeroWidth;
+
+            public UnicodeNormalizeTransform(NormalizationType type, bool stripZeroWidth)
+            {
+                _type = (int)type;
+                _stripZeroWidth = stripZeroWidth ? 1 : 0;
+            }
+
+            public unsafe int Run(ReadOnlySpan<char> input, Span<char> output)
+            {
+                fixed (char* inputPtr = input)
+                fixed (char* outputPtr = output)
+                {
+                    return unicode_confusables_unicode_normalize_utf16(inputPtr, input.Length, _type, _stripZeroWidth, outputPtr, output.Length);
+                }
+            }
+
+            public string Decode(ReadOnlySpan<char> output) => new string(output);
+        }
+
+        // Runs the transform into a stack or pooled buffer of initialCapacity code units (growing once if the
+        // native side reports a larger size) and decodes the result; null on failure
+        private static string TransformToString<TUnit, T>(ReadOnlySpan<TUnit> input, int initialCapacity, T transform)
+            where TUnit : unmanaged
+            where T : struct, ITextTransform<TUnit>
+        {
+            TUnit[] rented = null;
+            Span<TUnit> output = initialCapacity <= StackallocThreshold
+                ? stackalloc TUnit[StackallocThreshold]
+                : (rented = ArrayPool<TUnit>.Shared.Rent(initialCapacity));
+            try
+            {
+                int required = transform.Run(input, output);
+                if (required > output.Length)
+                {
+                    if (rented != null)
+                        ArrayPool<TUnit>.Shared.Return(rented);
+                    rented = null;
+                    rented = ArrayPool<TUnit>.Shared.Rent(required);
+                    output = rented;
+                    required = transform.Run(input, output);
+                }
+                if (required < 0 || required > output.Length)
+                    return null;
+                return transform.Decode(output.Slice(0, required));
+            }
+            finally
+            {
+                if (rented != null)
+                    ArrayPool<TUnit>.Shared.Return(rented);
+            }
+        }
     }
 }
@@ -1,5 +1,6 @@
 #include "unicode_confusables_c.h"
 #include "../../include/unicode_confusables.h"
+#include <climits>
 #include <vector>
 #include <cstring>
 #include <cstdlib>
@@ -9,6 +10,81 @@ struct ConfusablesSet {
     std::vector<std::string> items;
 };
 
+static bool to_normalization_type(int type, unicode_confusables::NormalizationType& norm_type) {
+    switch (type) {
+        case 0: norm_type = unicode_confusables::NormalizationType::NFC; return true;
+        case 1: norm_type = unicode_confusables::NormalizationType::NFD; return true;
+        case 2: norm_type = unicode_confusables::NormalizationType::NFKC; return true;
+        case 3: norm_type = unicode_confusables::NormalizationType::NFKD; return true;
+        default: return false;
+    }
+}
+
+template <typename Unit>
+static bool valid_span_args(const Unit* input, int input_length, const Unit* output, int output_capacity) {
+    return (input || input_length == 0) && input_length >= 0 && (output || output_capacity == 0) && output_capacity >= 0;
+}
+
+// Copies result into output if it fits and returns its length, or -1 if that does not fit in an int
+template <typename Char, typename Unit>
+static int copy_to_span(const std::basic_string<Char>& result, Unit* output, int output_capacity) {
+    static_assert(sizeof(Char) == sizeof(Unit), "code unit size mismatch");
+    if (result.size() > static_cast<size_t>(INT_MAX)) return -1;
+    if (result.size() <= static_cast<size_t>(output_capacity)) {
+        std::memcpy(output, result.data(), result.size() * sizeof(Unit));
+    }
+    return static_cast<int>(result.size());
+}
+
+// C code units (uint16_t / uint32_t) viewed as the C++ character type of the same encoding
+template <typename Char, typename Unit>
+static std::basic_string_view<Char> as_view(const Unit* input, int input_length) {
+    static_assert(sizeof(Char) == sizeof(Unit), "code unit size mismatch");
+    return std::basic_string_view<Char>(reinterpret_cast<const Char*>(input), static_cast<size_t>(input_length));
+}
+
+template <typename Char, typename Unit>
+static int normalize_confusables_span(const Unit* input, int input_length, Unit* output, int output_capacity, int fold_case) {
+    if (!valid_span_args(input, input_length, output, output_capacity)) return -1;
+
+    try {
+        auto result = unicode_confusables::normalize_confusables(as_view<Char>(input, input_length), fold_case != 0);
+        return copy_to_span(result, output, output_capacity);
+    } catch (...) {
+        return -1;
+    }
+}
+
+template <typename Char, typename Unit>
+static int unicode_normalize_span(const Unit* input, int input_length, int type, int strip_zero_width, Unit* output, int output_capacity) {
+    if (!valid_span_args(input, input_length, output, output_capacity)) return -1;
+
+    try {
+        unicode_confusables::NormalizationType norm_type;
+        if (!to_normalization_type(type, norm_type)) return -1;
+        auto result = unicode_confusables::unicode_normalize(as_view<Char>(input, input_length), norm_type, strip_zero_width != 0);
+        return copy_to_span(result, output, output_capacity);
+    } catch (...) {
+        return -1;
+    }
+}
+
+template <typename Char, typename Unit>
+static int contains_confusables_span(const Unit* input, int input_length, Unit* output, int output_capacity) {
+    if (!valid_span_args(input, input_length, output, output_capacity)) return -1;
+
+    try {
+        auto confusables = unicode_confusables::contains_confusables(as_view<Char>(input, input_length));
+        std::basic_string<Char> joined;
+        for (const auto& item : confusables) {
+            joined += item;
+        }
+        return copy_to_span(joined, output, output_capacity);
+    } catch (...) {
+        return -1;
+    }
+}
+
 extern "C" {
 
 ConfusablesSetHandle unicode_confusables_contains_confusables(const char* input) {
@@ -45,11 +121,11 @@ const char* unicode_confusables_set_get(ConfusablesSetHandle handle, int index)
     return handle->items[index].c_str();
 }
 
-char* unicode_confusables_normalize_confusables(const char* input) {
+static char* normalize_confusables_c(const char* input, bool fold_case) {
     if (!input) return nullptr;
     
     try {
-        std::string result = unicode_confusables::normalize_confusables(std::string(input));
+        std::string result = unicode_confusables::normalize_confusables(std::string(input), fold_case);
         char* c_result = static_cast<char*>(malloc(result.length() + 1));
         if (c_result) {
             strcpy(c_result, result.c_str());
@@ -60,18 +136,20 @@ char* unicode_confusables_normalize_confusables(const char* input) {
     }
 }
 
+char* unicode_confusables_normalize_confusables(const char* input) {
+    return normalize_confusables_c(input, false);
+}
+
+char* unicode_confusables_normalize_confusables_fold_case(const char* input) {
+    return normalize_confusables_c(input, true);
+}
+
 char* unicode_confusables_unicode_normalize(const char* input, int type, int strip_zero_width) {
     if (!input) return nullptr;
     
     try {
         unicode_confusables::NormalizationType norm_type;
-        switch (type) {
-            case 0: norm_type = unicode_confusables::NormalizationType::NFC; break;
-            case 1: norm_type = unicode_confusables::NormalizationType::NFD; break;
-            case 2: norm_type = unicode_confusables::NormalizationType::NFKC; break;
-            case 3: norm_type = unicode_confusables::NormalizationType::NFKD; break;
-            default: return nullptr;
-        }
+        if (!to_normalization_type(type, norm_type)) return nullptr;
         
         std::string result = unicode_confusables::unicode_normalize(std::string(input), norm_type, strip_zero_width != 0);
         char* c_result = static_cast<char*>(malloc(result.length() + 1));
@@ -88,4 +166,54 @@ void unicode_confusables_free_string(char* str) {
     free(str);
 }
 
+int unicode_confusables_normalize_confusables_utf8(const char* input, int input_length, char* output, int output_capacity, int fold_case) {
+    if (!valid_span_args(input, input_length, output, output_capacity)) return -1;
+
+    try {
+        size_t required = unicode_confusables::normalize_confusables_into(
+            std::string_view(input, static_cast<size_t>(input_length)), output, static_cast<size_t>(output_capacity), fold_case != 0);
+        return required > static_cast<size_t>(INT_MAX) ? -1 : static_cast<int>(required);
+    } catch (...) {
+        return -1;
+    }
+}
+
+int unicode_confusables_unicode_normalize_utf8(const char* input, int input_length, int type, int strip_zero_width, char* output, int output_capacity) {
+    return unicode_normalize_span<char>(input, input_length, type, strip_zero_width, output, output_capacity);
+}
+
+int unicode_confusables_contains_confusables_utf8(const char* input, int input_length, char* output, int output_capacity) {
+    return contains_confusables_span<char>(input, input_length, output, output_capacity);
+}
+
+int unicode_confusables_normalize_confusables_max_length(int input_length) {
+    if (input_length < 0) return -1;
+    size_t max_size = unicode_confusables::normalize_confusables_max_size(static_cast<size_t>(input_length));
+    return max_size > static_cast<size_t>(INT_MAX) ? -1 : static_cast<int>(max_size);
+}
+
+int unicode_confusables_normalize_confusables_utf16(const uint16_t* input, int input_length, uint16_t* output, int output_capacity, int fold_case) {
+    return normalize_confusables_span<char16_t>(input, input_length, output, output_capacity, fold_case);
+}
+
+int unicode_confusables_unicode_normalize_utf16(const uint16_t* input, int input_length, int type, int strip_zero_width, uint16_t* output, int output_capacity) {
+    return unicode_normalize_span<char16_t>(input, input_length, type, strip_zero_width, output, output_capacity);
+}
+
+int unicode_confusables_contains_confusables_utf16(const uint16_t* input, int input_length, uint16_t* output, int output_capacity) {
+    return contains_confusables_span<char16_t>(input, input_length, output, output_capacity);
+}
+
+int unicode_confusables_normalize_confusables_utf32(const uint32_t* input, int input_length, uint32_t* output, int output_capacity, int fold_case) {
+    return normalize_confusables_span<char32_t>(input, input_length, output, output_capacity, fold_case);
+}
+
+int unicode_confusables_unicode_normalize_utf32(const uint32_t* input, int input_length, int type, int strip_zero_width, uint32_t* output, int output_capacity) {
+    return unicode_normalize_span<char32_t>(input, input_length, type, strip_zero_width, output, output_capacity);
+}
+
+int unicode_confusables_contains_confusables_utf32(const uint32_t* input, int input_length, uint32_t* output, int output_capacity) {
+    return contains_confusables_span<char32_t>(input, input_length, output, output_capacity);
+}
+
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,9 +15,32 @@ int unicode_confusables_set_size(ConfusablesSetHandle handle);
 const char* unicode_confusables_set_get(ConfusablesSetHandle handle, int index);
 
 char* unicode_confusables_normalize_confusables(const char* input);
+char* unicode_confusables_normalize_confusables_fold_case(const char* input);
 char* unicode_confusables_unicode_normalize(const char* input, int type, int strip_zero_width);
 void unicode_confusables_free_string(char* str);
 
+// Span-based entry points: input is a UTF-8 byte range (need not be NUL-terminated) and results are
+// written into a caller-provided buffer, so no native memory has to be returned or freed.
+// Each returns the number of bytes the full result needs (the output is complete only if that is
+// <= output_capacity), or -1 on invalid arguments or if that length does not fit in an int.
+int unicode_confusables_normalize_confusables_utf8(const char* input, int input_length, char* output, int output_capacity, int fold_case);
+int unicode_confusables_unicode_normalize_utf8(const char* input, int input_length, int type, int strip_zero_width, char* output, int output_capacity);
+// Writes the distinct confusable characters found in input back to back (each is one UTF-8 codepoint).
+int unicode_confusables_contains_confusables_utf8(const char* input, int input_length, char* output, int output_capacity);
+// Upper bound on unicode_confusables_normalize_confusables_utf8 output for input_length bytes.
+// Pure arithmetic: never blocks, allocates or calls back, so managed callers may skip the GC transition.
+int unicode_confusables_normalize_confusables_max_length(int input_length);
+
+// The same span-based entry points for UTF-16 and UTF-32 text. Lengths and capacities count code units, and
+// results are produced in the input's encoding, so UTF-16 hosts need no transcoding on either side.
+// Unpaired surrogates and out-of-range code points read as U+FFFD.
+int unicode_confusables_normalize_confusables_utf16(const uint16_t* input, int input_length, uint16_t* output, int output_capacity, int fold_case);
+int unicode_confusables_unicode_normalize_utf16(const uint16_t* input, int input_length, int type, int strip_zero_width, uint16_t* output, int output_capacity);
+int unicode_confusables_contains_confusables_utf16(const uint16_t* input, int input_length, uint16_t* output, int output_capacity);
+int unicode_confusables_normalize_confusables_utf32(const uint32_t* input, int input_length, uint32_t* output, int output_capacity, int fold_case);
+int unicode_confusables_unicode_normalize_utf32(const uint32_t* input, int input_length, int type, int strip_zero_width, uint32_t* output, int output_capacity);
+int unicode_confusables_contains_confusables_utf32(const uint32_t* input, int input_length, uint32_t* output, int output_capacity);
+
 #ifdef __cplusplus
 }
 #endif
@@ -49,6 +49,8 @@ ext_modules = [
             "unicode_confusables_py.cpp",
             "../../src/unicode_confusables.cpp",
             "../../src/unicode_confusables_data.cpp",
+            "../../src/unicode_confusables_distance.cpp",
+            "../../src/unicode_confusables_offsets.cpp",
         ],
         include_dirs=[
             # Path to pybind11 headers
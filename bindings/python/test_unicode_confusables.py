@@ -54,6 +54,34 @@ try:
     except Exception as ex:
         print(f"Error with Unicode normalization: {ex}")
 
+    # Test zero-copy bytes-like input and batch variants
+    try:
+        encoded = test_input.encode("utf-8")
+        normalized_bytes = unicode_confusables.normalize_confusables(encoded)
+        assert isinstance(normalized_bytes, bytes)
+        assert normalized_bytes.decode("utf-8") == unicode_confusables.normalize_confusables(test_input)
+        assert unicode_confusables.normalize_confusables(memoryview(encoded)) == normalized_bytes
+        print(f"Bytes Normalized: {normalized_bytes!r}")
+
+        batch = unicode_confusables.normalize_confusables_batch([test_input, encoded, "plain"])
+        assert batch == [normalized_bytes.decode("utf-8"), normalized_bytes, "plain"]
+        found = unicode_confusables.contains_confusables_batch([test_input, "plain"])
+        assert found[0] == unicode_confusables.contains_confusables(test_input) and not found[1]
+        print(f"Batch Normalized: {batch}")
+    except Exception as ex:
+        print(f"Error with bytes/batch normalization: {ex}")
+
+    # Test confusable-aware edit distance
+    try:
+        distance = unicode_confusables.confusable_distance("paypa1-support", "p\u0430ypal_support", 5)
+        assert distance == 2
+        assert unicode_confusables.confusable_distance("paypal", "PAYPAL", 3, fold_case=True) == 0
+        distances = unicode_confusables.confusable_distances("paypal", ["p\u0430ypal", "paypa1", "unrelated"], 2)
+        assert distances == [0, 1, 3]
+        print(f"Confusable distances: {distances}")
+    except Exception as ex:
+        print(f"Error with confusable distance: {ex}")
+
     # Test legacy unicode_normalize_kd (for backward compatibility)
     try:
         kd_normalized = unicode_confusables.unicode_normalize_kd(test_input, strip_zero_width=True)
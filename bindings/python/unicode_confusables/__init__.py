@@ -4,7 +4,7 @@ Python wrapper for Unicode Confusables detection and normalization.
 This module provides utilities for detecting and normalizing Unicode confusable characters.
 """
 
-from typing import Set
+from typing import Iterable, List, Set, Union
 from enum import IntEnum
 
 try:
@@ -24,76 +24,100 @@ except ImportError:
         NFKD = 3  # Normalization Form Compatibility Decomposed
 
 __version__ = "1.0.0"
-__all__ = ["contains_confusables", "normalize_confusables", "unicode_normalize", "unicode_normalize_kd", "NormalizationType"]
+__all__ = ["contains_confusables", "normalize_confusables", "unicode_normalize", "unicode_normalize_kd",
+           "contains_confusables_batch", "normalize_confusables_batch", "unicode_normalize_batch",
+           "confusable_distance", "confusable_distances",
+           "NormalizationType"]
 
+# Inputs are passed to the native module without copying: str through its cached UTF-8
+# representation, bytes-like objects through the buffer protocol. Results mirror the input
+# type (str in, str out; bytes-like in, bytes out). The GIL is released while processing.
+TextInput = Union[str, bytes, bytearray, memoryview]
+_TEXT_TYPES = (str, bytes, bytearray, memoryview)
 
-def contains_confusables(input_text: str) -> Set[str]:
+
+def _require_backend():
+    if _backend is None:
+        raise RuntimeError("Native unicode_confusables_py module not available. Build the extension first.")
+
+
+def _check_batch(inputs) -> list:
+    if isinstance(inputs, _TEXT_TYPES):
+        raise TypeError("inputs must be an iterable of strings or bytes-like objects, not a single string")
+    inputs = inputs if isinstance(inputs, (list, tuple)) else list(inputs)
+    for item in inputs:
+        if not isinstance(item, _TEXT_TYPES):
+            raise TypeError("every input must be a string or bytes-like object")
+    return inputs
+
+
+def contains_confusables(input_text: TextInput) -> Set[str]:
     """
     Returns the set of confusable Unicode characters found in the input string.
     
     Args:
-        input_text: The input string to analyze
+        input_text: The input string (or UTF-8 bytes-like object) to analyze
         
     Returns:
         A set containing the confusable characters found
         
     Raises:
-        TypeError: If input_text is not a string
+        TypeError: If input_text is not a string or bytes-like object
         RuntimeError: If the native module is not available
     """
-    if _backend is None:
-        raise RuntimeError("Native unicode_confusables_py module not available. Build the extension first.")
+    _require_backend()
     
-    if not isinstance(input_text, str):
-        raise TypeError("input_text must be a string")
+    if not isinstance(input_text, _TEXT_TYPES):
+        raise TypeError("input_text must be a string or bytes-like object")
     
     return _backend.contains_confusables(input_text)
 
 
-def normalize_confusables(input_text: str) -> str:
+def normalize_confusables(input_text: TextInput, fold_case: bool = False) -> TextInput:
     """
     Returns a new string with confusable characters replaced by their canonical equivalents.
     
     Args:
-        input_text: The input string to normalize
+        input_text: The input string (or UTF-8 bytes-like object) to normalize
+        fold_case: If True, the result is also case folded (single lookup per codepoint)
         
     Returns:
-        A normalized string with confusables replaced
+        A normalized string with confusables replaced (bytes for bytes-like input)
         
     Raises:
-        TypeError: If input_text is not a string
+        TypeError: If input_text is not a string or bytes-like object, or fold_case is not a boolean
         RuntimeError: If the native module is not available
     """
-    if _backend is None:
-        raise RuntimeError("Native unicode_confusables_py module not available. Build the extension first.")
+    _require_backend()
     
-    if not isinstance(input_text, str):
-        raise TypeError("input_text must be a string")
+    if not isinstance(input_text, _TEXT_TYPES):
+        raise TypeError("input_text must be a string or bytes-like object")
+    if not isinstance(fold_case, bool):
+        raise TypeError("fold_case must be a boolean")
     
-    return _backend.normalize_confusables(input_text)
+    return _backend.normalize_confusables(input_text, fold_case)
 
 
-def unicode_normalize(input_text: str, normalization_type: NormalizationType, strip_zero_width: bool = False) -> str:
+def unicode_normalize(input_text: TextInput, normalization_type: NormalizationType, strip_zero_width: bool = False) -> TextInput:
     """
     Returns a new string with Unicode normalization applied.
     
     Args:
-        input_text: The input string to normalize
+        input_text: The input string (or UTF-8 bytes-like object) to normalize
         normalization_type: The type of normalization to apply (NFC, NFD, NFKC, or NFKD)
         strip_zero_width: If True, zero-width characters are removed after normalization
         
     Returns:
-        A normalized string
+        A normalized string (bytes for bytes-like input)
         
     Raises:
         TypeError: If arguments are not of the correct type
         RuntimeError: If the native module is not available
     """
-    if _backend is None:
-        raise RuntimeError("Native unicode_confusables_py module not available. Build the extension first.")
+    _require_backend()
     
-    if not isinstance(input_text, str):
-        raise TypeError("input_text must be a string")
+    if not isinstance(input_text, _TEXT_TYPES):
+        raise TypeError("input_text must be a string or bytes-like object")
     if not isinstance(normalization_type, (NormalizationType, int)):
         raise TypeError("normalization_type must be a NormalizationType")
     if not isinstance(strip_zero_width, bool):
@@ -109,7 +133,7 @@ def unicode_normalize_kd(input_text: str, strip_zero_width: bool = False) -> str
     DEPRECATED: Use unicode_normalize with NormalizationType.NFKD instead.
     
     Args:
-        input_text: The input string to normalize
+        input_text: The input string (or UTF-8 bytes-like object) to normalize
         strip_zero_width: If True, zero-width characters are removed after normalization
         
     Returns:
@@ -120,3 +144,125 @@ def unicode_normalize_kd(input_text: str, strip_zero_width: bool = False) -> str
         RuntimeError: If the native module is not available
     """
     return unicode_normalize(input_text, NormalizationType.NFKD, strip_zero_width)
+
+
+def contains_confusables_batch(inputs: Iterable[TextInput]) -> List[Set[str]]:
+    """
+    Batch form of contains_confusables; the GIL is released once for the whole batch.
+    
+    Args:
+        inputs: Strings or UTF-8 bytes-like objects to analyze
+        
+    Returns:
+        A list with the set of confusable characters found in each input
+        
+    Raises:
+        TypeError: If inputs is not an iterable of strings or bytes-like objects
+        RuntimeError: If the native module is not available
+    """
+    _require_backend()
+    return _backend.contains_confusables_batch(_check_batch(inputs))
+
+
+def normalize_confusables_batch(inputs: Iterable[TextInput], fold_case: bool = False) -> List[TextInput]:
+    """
+    Batch form of normalize_confusables; the GIL is released once for the whole batch.
+    
+    Args:
+        inputs: Strings or UTF-8 bytes-like objects to normalize
+        fold_case: If True, the results are also case folded
+        
+    Returns:
+        A list with each input normalized (bytes for bytes-like inputs)
+        
+    Raises:
+        TypeError: If inputs is not an iterable of strings or bytes-like objects
+        RuntimeError: If the native module is not available
+    """
+    _require_backend()
+    if not isinstance(fold_case, bool):
+        raise TypeError("fold_case must be a boolean")
+    return _backend.normalize_confusables_batch(_check_batch(inputs), fold_case)
+
+
+def unicode_normalize_batch(inputs: Iterable[TextInput], normalization_type: NormalizationType, strip_zero_width: bool = False) -> List[TextInput]:
+    """
+    Batch form of unicode_normalize; the GIL is released once for the whole batch.
+    
+    Args:
+        inputs: Strings or UTF-8 bytes-like objects to normalize
+        normalization_type: The type of normalization to apply (NFC, NFD, NFKC, or NFKD)
+        strip_zero_width: If True, zero-width characters are removed after normalization
+        
+    Returns:
+        A list with each input normalized (bytes for bytes-like inputs)
+        
+    Raises:
+        TypeError: If arguments are not of the correct type
+        RuntimeError: If the native module is not available
+    """
+    _require_backend()
+    if not isinstance(normalization_type, (NormalizationType, int)):
+        raise TypeError("normalization_type must be a NormalizationType")
+    if not isinstance(strip_zero_width, bool):
+        raise TypeError("strip_zero_width must be a boolean")
+    return _backend.unicode_normalize_batch(_check_batch(inputs), normalization_type, strip_zero_width)
+
+
+def confusable_distance(a: TextInput, b: TextInput, max_k: int, fold_case: bool = False) -> int:
+    """
+    Returns the edit distance between the canonical forms of a and b (see normalize_confusables), counted in
+    codepoints, so "paypa1-support" and "pаypal_support" (Cyrillic 'а') are at distance 2.
+    
+    Args:
+        a, b: The strings (or UTF-8 bytes-like objects) to compare
+        max_k: Largest distance of interest; anything further returns max_k + 1 without finishing the comparison
+        fold_case: If True, the strings are compared case folded
+        
+    Returns:
+        The distance, or max_k + 1 if it exceeds max_k
+        
+    Raises:
+        TypeError: If arguments are not of the correct type
+        ValueError: If max_k is negative
+        RuntimeError: If the native module is not available
+    """
+    _require_backend()
+    if not isinstance(a, _TEXT_TYPES) or not isinstance(b, _TEXT_TYPES):
+        raise TypeError("a and b must be strings or bytes-like objects")
+    _check_distance_args(max_k, fold_case)
+    return _backend.confusable_distance(a, b, max_k, fold_case)
+
+
+def confusable_distances(query: TextInput, candidates: Iterable[TextInput], max_k: int, fold_case: bool = False) -> List[int]:
+    """
+    One-vs-many form of confusable_distance; the query is prepared once and the GIL is released for the whole list.
+    
+    Args:
+        query: The string (or UTF-8 bytes-like object) to compare against every candidate
+        candidates: Strings or UTF-8 bytes-like objects
+        max_k: Largest distance of interest; anything further returns max_k + 1
+        fold_case: If True, the strings are compared case folded
+        
+    Returns:
+        A list with the distance from query to each candidate
+        
+    Raises:
+        TypeError: If arguments are not of the correct type
+        ValueError: If max_k is negative
+        RuntimeError: If the native module is not available
+    """
+    _require_backend()
+    if not isinstance(query, _TEXT_TYPES):
+        raise TypeError("query must be a string or bytes-like object")
+    _check_distance_args(max_k, fold_case)
+    return _backend.confusable_distances(query, _check_batch(candidates), max_k, fold_case)
+
+
+def _check_distance_args(max_k, fold_case):
+    if not isinstance(max_k, int) or isinstance(max_k, bool):
+        raise TypeError("max_k must be an integer")
+    if max_k < 0:
+        raise ValueError("max_k must not be negative")
+    if not isinstance(fold_case, bool):
+        raise TypeError("fold_case must be a boolean")
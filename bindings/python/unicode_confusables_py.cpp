@@ -1,32 +1,204 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
+#include <memory>
+#include <string_view>
+#include <vector>
 #include "../../include/unicode_confusables.h"
+#include "../../include/unicode_confusables_distance.h"
 
 namespace py = pybind11;
 
+namespace {
+
+// Read-only UTF-8 view over a Python object, without copying it:
+// - str: the UTF-8 representation cached on the str object
+// - bytes: the bytes object's own storage
+// - any other buffer (bytearray, memoryview, ...): a PyBUF_SIMPLE buffer export
+// Holds a reference (and the buffer export) so the view stays valid while the GIL is released.
+class Utf8Input {
+public:
+    explicit Utf8Input(py::handle obj) : obj_(py::reinterpret_borrow<py::object>(obj)) {
+        PyObject* ptr = obj_.ptr();
+        if (PyUnicode_Check(ptr)) {
+            Py_ssize_t size = 0;
+            const char* data = PyUnicode_AsUTF8AndSize(ptr, &size);
+            if (data == nullptr) {
+                throw py::error_already_set();
+            }
+            view_ = std::string_view(data, static_cast<size_t>(size));
+            is_text_ = true;
+        } else if (PyBytes_Check(ptr)) {
+            char* data = nullptr;
+            Py_ssize_t size = 0;
+            if (PyBytes_AsStringAndSize(ptr, &data, &size) != 0) {
+                throw py::error_already_set();
+            }
+            view_ = std::string_view(data, static_cast<size_t>(size));
+        } else if (PyObject_CheckBuffer(ptr)) {
+            auto buffer = std::make_unique<Py_buffer>();
+            if (PyObject_GetBuffer(ptr, buffer.get(), PyBUF_SIMPLE) != 0) {
+                throw py::error_already_set();
+            }
+            buffer_.reset(buffer.release());
+            view_ = std::string_view(static_cast<const char*>(buffer_->buf), static_cast<size_t>(buffer_->len));
+        } else {
+            throw py::type_error("input must be str, bytes or a bytes-like object");
+        }
+    }
+
+    std::string_view view() const { return view_; }
+
+    // Wraps a result in the same kind of object as the input: str for str, bytes otherwise
+    py::object wrap(const std::string& result) const {
+        if (is_text_) {
+            return py::str(result);
+        }
+        return py::bytes(result);
+    }
+
+private:
+    struct BufferRelease {
+        void operator()(Py_buffer* buffer) const {
+            PyBuffer_Release(buffer);
+            delete buffer;
+        }
+    };
+
+    py::object obj_;
+    std::unique_ptr<Py_buffer, BufferRelease> buffer_;
+    std::string_view view_;
+    bool is_text_ = false;
+};
+
+std::vector<Utf8Input> collect_inputs(const py::iterable& inputs) {
+    std::vector<Utf8Input> views;
+    if (py::isinstance<py::sequence>(inputs)) {
+        views.reserve(py::len(inputs));
+    }
+    for (py::handle item : inputs) {
+        views.emplace_back(item);
+    }
+    return views;
+}
+
+py::set to_python_set(const std::unordered_set<std::string>& confusables) {
+    py::set result;
+    for (const auto& item : confusables) {
+        result.add(py::str(item));
+    }
+    return result;
+}
+
+// Runs fn over every input with the GIL released, then converts each result back to Python
+template <typename Fn, typename Convert>
+py::list run_batch(const py::iterable& inputs, Fn fn, Convert convert) {
+    std::vector<Utf8Input> views = collect_inputs(inputs);
+    std::vector<decltype(fn(std::string_view()))> results;
+    {
+        py::gil_scoped_release release;
+        results.reserve(views.size());
+        for (const auto& view : views) {
+            results.push_back(fn(view.view()));
+        }
+    }
+    py::list out(views.size());
+    for (size_t i = 0; i < views.size(); ++i) {
+        out[i] = convert(views[i], results[i]);
+    }
+    return out;
+}
+
+} // namespace
+
 PYBIND11_MODULE(unicode_confusables_py, m) {
     m.doc() = "Python bindings for Unicode Confusables detection and normalization";
-    
+
     // Bind the NormalizationType enum
     py::enum_<unicode_confusables::NormalizationType>(m, "NormalizationType")
         .value("NFC", unicode_confusables::NormalizationType::NFC, "Normalization Form Composed")
         .value("NFD", unicode_confusables::NormalizationType::NFD, "Normalization Form Decomposed")
         .value("NFKC", unicode_confusables::NormalizationType::NFKC, "Normalization Form Compatibility Composed")
         .value("NFKD", unicode_confusables::NormalizationType::NFKD, "Normalization Form Compatibility Decomposed");
-    
-    m.def("contains_confusables", &unicode_confusables::contains_confusables,
-          "Returns the set of confusable Unicode characters found in the input string",
-          py::arg("input"));
-    
-    m.def("normalize_confusables", &unicode_confusables::normalize_confusables,
-          "Returns a new string with confusable characters replaced by their canonical equivalents",
-          py::arg("input"));
-    
-    m.def("unicode_normalize", &unicode_confusables::unicode_normalize,
-          "Returns a new string with Unicode normalization applied. If strip_zero_width is True, zero-width characters are removed after normalization.",
-          py::arg("input"), py::arg("type"), py::arg("strip_zero_width") = false);
-    
+
+    // All entry points accept str (read through its cached UTF-8 form), bytes, or any
+    // bytes-like object without copying the input, and release the GIL while processing.
+    m.def("contains_confusables", [](py::handle input) {
+        Utf8Input in(input);
+        std::unordered_set<std::string> result;
+        {
+            py::gil_scoped_release release;
+            result = unicode_confusables::contains_confusables(in.view());
+        }
+        return to_python_set(result);
+    }, "Returns the set of confusable Unicode characters found in the input string",
+       py::arg("input"));
+
+    m.def("normalize_confusables", [](py::handle input, bool fold_case) {
+        Utf8Input in(input);
+        std::string result;
+        {
+            py::gil_scoped_release release;
+            result = unicode_confusables::normalize_confusables(in.view(), fold_case);
+        }
+        return in.wrap(result);
+    }, "Returns a new string with confusable characters replaced by their canonical equivalents. If fold_case is True, the result is also case folded. Returns bytes for bytes-like input.",
+       py::arg("input"), py::arg("fold_case") = false);
+
+    m.def("unicode_normalize", [](py::handle input, unicode_confusables::NormalizationType type, bool strip_zero_width) {
+        Utf8Input in(input);
+        std::string result;
+        {
+            py::gil_scoped_release release;
+            result = unicode_confusables::unicode_normalize(in.view(), type, strip_zero_width);
+        }
+        return in.wrap(result);
+    }, "Returns a new string with Unicode normalization applied. If strip_zero_width is True, zero-width characters are removed after normalization. Returns bytes for bytes-like input.",
+       py::arg("input"), py::arg("type"), py::arg("strip_zero_width") = false);
+
+    // Batch variants: the GIL is released once for the whole list
+    m.def("contains_confusables_batch", [](const py::iterable& inputs) {
+        return run_batch(inputs,
+            [](std::string_view in) { return unicode_confusables::contains_confusables(in); },
+            [](const Utf8Input&, const std::unordered_set<std::string>& r) -> py::object { return to_python_set(r); });
+    }, "Returns a list with the set of confusable characters found in each input",
+       py::arg("inputs"));
+
+    m.def("normalize_confusables_batch", [](const py::iterable& inputs, bool fold_case) {
+        return run_batch(inputs,
+            [fold_case](std::string_view in) { return unicode_confusables::normalize_confusables(in, fold_case); },
+            [](const Utf8Input& in, const std::string& r) { return in.wrap(r); });
+    }, "Returns a list with each input's confusables normalized. If fold_case is True, the results are also case folded.",
+       py::arg("inputs"), py::arg("fold_case") = false);
+
+    m.def("unicode_normalize_batch", [](const py::iterable& inputs, unicode_confusables::NormalizationType type, bool strip_zero_width) {
+        return run_batch(inputs,
+            [type, strip_zero_width](std::string_view in) { return unicode_confusables::unicode_normalize(in, type, strip_zero_width); },
+            [](const Utf8Input& in, const std::string& r) { return in.wrap(r); });
+    }, "Returns a list with Unicode normalization applied to each input",
+       py::arg("inputs"), py::arg("type"), py::arg("strip_zero_width") = false);
+
+    m.def("confusable_distance", [](py::handle a, py::handle b, size_t max_k, bool fold_case) {
+        Utf8Input first(a);
+        Utf8Input second(b);
+        py::gil_scoped_release release;
+        return unicode_confusables::confusable_distance(first.view(), second.view(), max_k, fold_case);
+    }, "Returns the edit distance in codepoints between the canonical forms of a and b, or max_k + 1 if it exceeds max_k",
+       py::arg("a"), py::arg("b"), py::arg("max_k"), py::arg("fold_case") = false);
+
+    m.def("confusable_distances", [](py::handle query, const py::iterable& candidates, size_t max_k, bool fold_case) {
+        Utf8Input in(query);
+        std::vector<Utf8Input> views = collect_inputs(candidates);
+        py::gil_scoped_release release;
+        std::vector<std::string_view> candidate_views;
+        candidate_views.reserve(views.size());
+        for (const auto& view : views) {
+            candidate_views.push_back(view.view());
+        }
+        return unicode_confusables::confusable_distances(in.view(), candidate_views, max_k, fold_case);
+    }, "Returns confusable_distance(query, candidate, max_k, fold_case) for every candidate",
+       py::arg("query"), py::arg("candidates"), py::arg("max_k"), py::arg("fold_case") = false);
+
     // Keep the old function for backward compatibility
     m.def("unicode_normalize_kd", [](const std::string& input, bool strip_zero_width) {
         return unicode_confusables::unicode_normalize(input, unicode_confusables::NormalizationType::NFKD, strip_zero_width);
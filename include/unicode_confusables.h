@@ -1,5 +1,7 @@
 #pragma once
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <unicode/unistr.h>
@@ -8,6 +10,8 @@
 
 namespace unicode_confusables {
 
+class OffsetMap;  // unicode_confusables_offsets.h
+
 // Unicode normalization types
 enum class NormalizationType {
     NFC,   // Normalization Form Composed
@@ -17,12 +21,43 @@ enum class NormalizationType {
 };
 
 // Returns the set of confusable Unicode characters found in the input string
-std::unordered_set<std::string> contains_confusables(const std::string& input);
+std::unordered_set<std::string> contains_confusables(std::string_view input);
+
+// Returns a new string with confusable characters replaced by their canonical equivalents.
+// If fold_case is true, the result is also case folded, using a precomputed composite table (one lookup per codepoint).
+std::string normalize_confusables(std::string_view input, bool fold_case = false);
+
+// Same as normalize_confusables, also recording in offsets where each output byte came from in input.
+std::string normalize_confusables(std::string_view input, bool fold_case, OffsetMap& offsets);
+
+// Writes the normalized form of input into output without allocating. Returns the number of bytes the
+// full result needs; output holds the complete result only if that is <= output_capacity.
+size_t normalize_confusables_into(std::string_view input, char* output, size_t output_capacity, bool fold_case = false);
 
-// Returns a new string with confusable characters replaced by their canonical equivalents
-std::string normalize_confusables(const std::string& input);
+// Normalizes buf[0, len) in place, updating len, as long as no replacement is longer than the UTF-8 it replaces
+// (e.g. Cyrillic 'а' (2 bytes) -> 'a'). Returns true if the whole buffer was normalized.
+// Returns false when the input needs the out-of-place path: buf[0, resume) is then already normalized and
+// buf[resume, len) is the unprocessed rest of the input, starting at the first growing replacement
+// (or ill-formed sequence, which becomes the 3-byte U+FFFD). Finish it with normalize_confusables.
+bool normalize_confusables_inplace(char* buf, size_t& len, size_t& resume, bool fold_case = false);
+
+// Upper bound on the size of normalize_confusables output for an input of input_size bytes, in either mode.
+size_t normalize_confusables_max_size(size_t input_size);
+
+// UTF-16 and UTF-32 variants, for callers that hold strings in those encodings. The input is decoded in place
+// and results are produced in the same encoding, with no transcoding to UTF-8. Results match the UTF-8 functions
+// on the transcoded input (unpaired surrogates and out-of-range code points read as U+FFFD).
+std::unordered_set<std::u16string> contains_confusables(std::u16string_view input);
+std::unordered_set<std::u32string> contains_confusables(std::u32string_view input);
+std::u16string normalize_confusables(std::u16string_view input, bool fold_case = false);
+std::u32string normalize_confusables(std::u32string_view input, bool fold_case = false);
+std::u16string unicode_normalize(std::u16string_view input, NormalizationType type, bool strip_zero_width);
+std::u32string unicode_normalize(std::u32string_view input, NormalizationType type, bool strip_zero_width);
 
 // Returns a new string with Unicode normalization applied. If strip_zero_width is true, zero-width characters are removed after normalization.
-std::string unicode_normalize(const std::string& input, NormalizationType type, bool strip_zero_width);
+std::string unicode_normalize(std::string_view input, NormalizationType type, bool strip_zero_width);
+
+// Same as unicode_normalize, also recording in offsets where each output byte came from in input.
+std::string unicode_normalize(std::string_view input, NormalizationType type, bool strip_zero_width, OffsetMap& offsets);
 
 } // namespace unicode_confusables
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace unicode_confusables {
+
+// A blocked pattern found in free text. [begin, end) are byte offsets in the original (unnormalized) input,
+// widened to whole codepoints.
+struct BlocklistMatch {
+    size_t pattern;  // index into the pattern list the matcher was built from
+    size_t begin;
+    size_t end;
+};
+
+// Multi-pattern matcher that sees through confusables. Patterns are canonicalized with the same tables as
+// normalize_confusables and compiled into an Aho-Corasick automaton over canonical UTF-8 bytes. Scanning
+// decodes the raw UTF-8 input and maps each codepoint to its canonical form inside the transition loop,
+// so a message is matched in one pass without building a normalized copy.
+class BlocklistMatcher {
+public:
+    // If fold_case is true, patterns and input are compared case-insensitively (see normalize_confusables)
+    explicit BlocklistMatcher(const std::vector<std::string>& patterns, bool fold_case = false);
+
+    // All matches, including overlapping ones, ordered by end offset
+    std::vector<BlocklistMatch> find_all(std::string_view text) const;
+
+    // True if any pattern occurs in text; stops at the first match
+    bool contains_any(std::string_view text) const;
+
+    size_t pattern_count() const { return pattern_lengths_.size(); }
+
+private:
+    // Feeds text through the automaton, calling on_match(match) until it returns false
+    template <typename OnMatch>
+    void scan(std::string_view text, OnMatch&& on_match) const;
+
+    uint32_t next_state(uint32_t state, uint8_t byte) const;
+
+    bool fold_case_;
+    std::vector<size_t> pattern_lengths_;  // canonical byte length per pattern; 0 for patterns that never match
+
+    // Automaton, state 0 is the root. Root transitions are a dense table; other states keep their
+    // goto edges sorted by byte in [edge_begin_[s], edge_begin_[s + 1]) and fall back along fail_.
+    std::vector<uint32_t> root_next_;
+    std::vector<uint32_t> edge_begin_;
+    std::vector<uint8_t> edge_bytes_;
+    std::vector<uint32_t> edge_targets_;
+    std::vector<uint32_t> fail_;
+    // Patterns ending exactly at state s are [output_begin_[s], output_begin_[s + 1]) in outputs_;
+    // dict_link_[s] is the nearest proper suffix state with outputs of its own (0 if none).
+    std::vector<uint32_t> output_begin_;
+    std::vector<uint32_t> outputs_;
+    std::vector<uint32_t> dict_link_;
+    size_t max_pattern_length_ = 0;
+};
+
+} // namespace unicode_confusables
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace unicode_confusables {
+
+// Optional memoizing front end for normalize_confusables / contains_confusables, for workloads that see
+// the same short strings (usernames, reactions, common words) over and over.
+//
+// Inputs of up to CACHE_MAX_INPUT_SIZE bytes are looked up by hash in two bounded tiers:
+// - a per-thread tier (set-associative, CLOCK eviction) that needs no synchronization, and
+// - a shared read-mostly tier (striped, shared_mutex) that warms up new threads.
+// Results are stored inline in the entries; results longer than CACHE_MAX_RESULT_SIZE and longer inputs
+// bypass the cache and are computed directly. Results are identical to the uncached functions.
+
+constexpr size_t CACHE_MAX_INPUT_SIZE = 32;
+constexpr size_t CACHE_MAX_RESULT_SIZE = 64;
+constexpr size_t CACHE_THREAD_ENTRIES = 1024;
+constexpr size_t CACHE_SHARED_ENTRIES = 4096;
+
+struct CacheStats {
+    uint64_t thread_hits = 0;  // served from the calling thread's tier
+    uint64_t shared_hits = 0;  // served from the shared tier
+    uint64_t misses = 0;       // computed and (if the result fits) inserted
+    uint64_t bypassed = 0;     // input or result too large to cache
+};
+
+// Same as normalize_confusables, memoized
+std::string cached_normalize_confusables(std::string_view input, bool fold_case = false);
+
+// Same as contains_confusables, memoized
+std::unordered_set<std::string> cached_contains_confusables(std::string_view input);
+
+// Hit/miss counters summed over all threads (including threads that have exited)
+CacheStats cache_stats();
+
+} // namespace unicode_confusables
@@ -0,0 +1,63 @@
+#pragma once
+#include "unicode_confusables_protocol.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace unicode_confusables {
+
+// Client for NormalizationServer (Linux only). Not thread-safe: use one client per thread.
+//
+// The single-call methods do one round trip each. For throughput, queue requests with send() and collect them
+// with receive(): the client writes queued requests while it waits, so any number may be outstanding without
+// either side blocking on a full socket buffer. Responses come back in the order the requests were sent.
+class NormalizationClient {
+public:
+    NormalizationClient() = default;
+    ~NormalizationClient();
+
+    NormalizationClient(const NormalizationClient&) = delete;
+    NormalizationClient& operator=(const NormalizationClient&) = delete;
+
+    // Returns false with error() set if the server cannot be reached
+    bool connect(const std::string& socket_path);
+    void close();
+    bool connected() const { return fd_ >= 0; }
+
+    const std::string& error() const { return error_; }
+
+    // Same results as the library functions. Return false on connection errors or an error status, and without
+    // sending anything while requests queued with send() have not been received.
+    bool normalize_confusables(std::string_view input, std::string& out, bool fold_case = false);
+    bool contains_confusables(std::string_view input, std::unordered_set<std::string>& out);
+
+    // Queues a request and returns its id; nothing is written until flush() or receive()
+    uint32_t send(protocol::Operation operation, uint8_t flags, std::string_view payload);
+    // Writes all queued requests
+    bool flush();
+    // Waits for the next response; false on connection errors
+    bool receive(protocol::Response& response);
+    // Sends requests pipelined and fills responses in the same order
+    bool call(const std::vector<protocol::Request>& requests, std::vector<protocol::Response>& responses);
+
+private:
+    // Waits until the socket can make progress, then writes queued requests and reads what has arrived
+    bool pump();
+    // Sends one request and receives its response, which must carry the request's id and status OK
+    bool round_trip(protocol::Operation operation, uint8_t flags, std::string_view payload, protocol::Response& response);
+    bool fail(const std::string& message);
+
+    int fd_ = -1;
+    uint32_t next_id_ = 0;
+    size_t outstanding_ = 0;  // sent requests whose responses have not been received
+    std::string output_;
+    size_t output_sent_ = 0;
+    std::string input_;
+    size_t input_used_ = 0;
+    std::string error_;
+};
+
+} // namespace unicode_confusables
@@ -0,0 +1,207 @@
+#pragma once
+#include "unicode_confusables_constexpr_data.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace unicode_confusables {
+
+// Compile-time normalization, for blocklists and reserved names embedded in the source. The functions here are
+// constexpr (C++17) and give the same results as normalize_confusables, using sorted constexpr copies of the
+// tables (unicode_confusables_constexpr_data.h) instead of the runtime hash maps. With C++20,
+// confusable_literal and confusable_name_set below canonicalize string literals with zero startup cost:
+//
+//     static_assert(confusable_literal<"p\xD0\xB0ypal">.view() == "paypal");
+//     using Reserved = confusable_name_set<"admin", "root", "support">;
+//     if (Reserved::contains(normalize_confusables(username))) { ... }
+namespace compile_time {
+
+// Result of compile-time normalization, stored inline
+template <size_t Capacity>
+struct FixedString {
+    char data[Capacity + 1] = {};
+    size_t size = 0;
+
+    constexpr std::string_view view() const { return std::string_view(data, size); }
+};
+
+namespace detail {
+
+// Decodes one codepoint at i like U8_NEXT_OR_FFFD: an ill-formed sequence (its maximal subpart) reads as U+FFFD
+constexpr char32_t decode_utf8(std::string_view input, size_t& i) {
+    uint8_t lead = static_cast<uint8_t>(input[i++]);
+    if (lead < 0x80) {
+        return lead;
+    }
+    size_t trail_count = 0;
+    char32_t cp = 0;
+    uint8_t low = 0x80;
+    uint8_t high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        trail_count = 1;
+        cp = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        trail_count = 2;
+        cp = lead & 0x0F;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        trail_count = 3;
+        cp = lead & 0x07;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return 0xFFFD;
+    }
+    for (size_t k = 0; k < trail_count; ++k) {
+        if (i >= input.size()) {
+            return 0xFFFD;
+        }
+        uint8_t trail = static_cast<uint8_t>(input[i]);
+        if (trail < low || trail > high) {
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (trail & 0x3F);
+        ++i;
+        low = 0x80;
+        high = 0xBF;
+    }
+    return cp;
+}
+
+// Canonical UTF-8 for cp, or an empty view if cp maps to itself
+constexpr std::string_view find_canonical(char32_t cp, bool fold_case) {
+    const constexpr_data::Entry* first = fold_case ? std::begin(constexpr_data::CONFUSABLE_TO_CANONICAL_FOLDED)
+                                                   : std::begin(constexpr_data::CONFUSABLE_TO_CANONICAL);
+    const constexpr_data::Entry* last = fold_case ? std::end(constexpr_data::CONFUSABLE_TO_CANONICAL_FOLDED)
+                                                  : std::end(constexpr_data::CONFUSABLE_TO_CANONICAL);
+    // Lower bound on source (std::lower_bound is not constexpr before C++20)
+    size_t count = static_cast<size_t>(last - first);
+    while (count > 0) {
+        size_t half = count / 2;
+        if (first[half].source < cp) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    if (first != last && first->source == cp) {
+        return std::string_view(constexpr_data::CANONICAL_BYTES + first->offset, first->length);
+    }
+    return std::string_view();
+}
+
+// UTF-8 for cp into out (at least 4 bytes), returns its length
+constexpr size_t encode_utf8(char32_t cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (cp >> 18));
+    out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Calls append(bytes, length) with the canonical UTF-8 of every codepoint of input
+template <typename Append>
+constexpr void normalize(std::string_view input, bool fold_case, Append&& append) {
+    for (size_t i = 0; i < input.size(); ) {
+        char32_t cp = decode_utf8(input, i);
+        std::string_view canonical = find_canonical(cp, fold_case);
+        if (!canonical.empty()) {
+            append(canonical.data(), canonical.size());
+        } else {
+            char utf8[4] = {};
+            append(utf8, encode_utf8(cp, utf8));
+        }
+    }
+}
+
+// Deliberately not constexpr: reaching it during constant evaluation is a compile error
+inline void capacity_exceeded() {}
+
+} // namespace detail
+
+// Size in bytes of normalize_confusables(input, fold_case)
+constexpr size_t normalized_size(std::string_view input, bool fold_case = false) {
+    size_t size = 0;
+    detail::normalize(input, fold_case, [&](const char*, size_t length) { size += length; });
+    return size;
+}
+
+// normalize_confusables(input, fold_case) into a FixedString; Capacity must be at least normalized_size(input, fold_case).
+// A smaller Capacity does not compile when evaluated at compile time; at run time the output is truncated.
+template <size_t Capacity>
+constexpr FixedString<Capacity> normalize_confusables(std::string_view input, bool fold_case = false) {
+    FixedString<Capacity> result;
+    detail::normalize(input, fold_case, [&](const char* bytes, size_t length) {
+        for (size_t k = 0; k < length; ++k) {
+            if (result.size == Capacity) {
+                detail::capacity_exceeded();
+                return;
+            }
+            result.data[result.size++] = bytes[k];
+        }
+    });
+    return result;
+}
+
+} // namespace compile_time
+
+#if __cplusplus >= 202002L
+
+// A string literal usable as a template argument
+template <size_t N>
+struct StringLiteral {
+    char value[N] = {};
+
+    consteval StringLiteral(const char (&literal)[N]) { std::copy(literal, literal + N, value); }
+    constexpr std::string_view view() const { return std::string_view(value, N - 1); }
+};
+
+// The canonical form of a string literal, computed at compile time: confusable_literal<"...">.view()
+template <StringLiteral Literal, bool FoldCase = false>
+inline constexpr auto confusable_literal =
+    compile_time::normalize_confusables<compile_time::normalized_size(Literal.view(), FoldCase)>(Literal.view(), FoldCase);
+
+// A set of names canonicalized and sorted at compile time. contains() is a binary search over the canonical
+// forms, so callers pass an already normalized string (normalize_confusables with the same FoldCase).
+template <bool FoldCase, StringLiteral... Names>
+struct basic_confusable_name_set {
+    static constexpr std::array<std::string_view, sizeof...(Names)> canonical_names = []() {
+        std::array<std::string_view, sizeof...(Names)> names = {confusable_literal<Names, FoldCase>.view()...};
+        std::sort(names.begin(), names.end());
+        return names;
+    }();
+
+    static constexpr bool contains(std::string_view canonical) {
+        auto it = std::lower_bound(canonical_names.begin(), canonical_names.end(), canonical);
+        return it != canonical_names.end() && *it == canonical;
+    }
+};
+
+template <StringLiteral... Names>
+using confusable_name_set = basic_confusable_name_set<false, Names...>;
+
+template <StringLiteral... Names>
+using folded_confusable_name_set = basic_confusable_name_set<true, Names...>;
+
+#endif
+
+} // namespace unicode_confusables
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace unicode_confusables {
+
+// Levenshtein distance between the canonical forms of a and b (normalize_confusables with fold_case), counted in
+// codepoints, so "paypa1-support" and "pаypal_support" (Cyrillic 'а') are at distance 2. Returns max_k + 1 as
+// soon as the distance is known to exceed max_k.
+//
+// Both strings are canonicalized straight into codepoints, without building the normalized UTF-8, and compared
+// with Myers' bit-parallel algorithm (Hyyrö's formulation, one machine word per 64 codepoints of the shorter
+// string). Pairs whose lengths differ by more than max_k are rejected before any comparison.
+size_t confusable_distance(std::string_view a, std::string_view b, size_t max_k, bool fold_case = false);
+
+// confusable_distance(query, candidate, max_k, fold_case) for every candidate. The query is canonicalized and
+// its match masks built once; for queries of up to 64 codepoints, candidates are compared several at a time in
+// independent lanes.
+std::vector<size_t> confusable_distances(std::string_view query, const std::vector<std::string_view>& candidates,
+                                         size_t max_k, bool fold_case = false);
+
+} // namespace unicode_confusables
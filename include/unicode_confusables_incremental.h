@@ -0,0 +1,55 @@
+#pragma once
+#include "unicode_confusables_offsets.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace unicode_confusables {
+
+// Output bytes [begin, begin + removed) of the previous output were replaced by output()[begin, begin + inserted)
+struct NormalizationPatch {
+    size_t begin;
+    size_t removed;
+    size_t inserted;
+};
+
+// Keeps a text, its normalize_confusables output and the offset map between them up to date under edits,
+// e.g. for a compose box that re-checks the text after every keystroke.
+//
+// normalize_confusables looks codepoints up one at a time (table keys longer than one codepoint never apply), so
+// each codepoint's output depends on that codepoint alone and an edit only affects the codepoints it touches.
+// replace() widens the edited range to bytes that cannot continue a UTF-8 sequence on both sides (so
+// ill-formed input splits the same way as in a full pass), normalizes just that window and patches the
+// output and offsets.
+//
+// Only the normalization is incremental. input() and output() are contiguous strings and the offset map a
+// vector of runs with absolute offsets, so each edit still moves everything after it: a memmove of the text
+// and a pass over the later runs, linear in the document but far cheaper than re-normalizing it (about a
+// third of a millisecond per edit on 600 KB of mixed-script text). Suited to compose boxes and documents
+// of moderate size; very large documents are better split, e.g. into paragraphs with one normalizer each.
+class IncrementalNormalizer {
+public:
+    explicit IncrementalNormalizer(bool fold_case = false) : fold_case_(fold_case) {}
+    IncrementalNormalizer(std::string_view text, bool fold_case = false);
+
+    // Replaces the whole text
+    void assign(std::string_view text);
+
+    // Replaces input bytes [begin, end) with text. Offsets past the end are clamped to the input size.
+    // Returns the part of the output that changed.
+    NormalizationPatch replace(size_t begin, size_t end, std::string_view text);
+
+    const std::string& input() const { return input_; }
+    // Always equal to normalize_confusables(input(), fold_case)
+    const std::string& output() const { return output_; }
+    const OffsetMap& offsets() const { return offsets_; }
+    bool fold_case() const { return fold_case_; }
+
+private:
+    bool fold_case_;
+    std::string input_;
+    std::string output_;
+    OffsetMap offsets_;
+};
+
+} // namespace unicode_confusables
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace unicode_confusables {
+
+// Run-length encoded correspondence between byte offsets in an input string and in its normalized output,
+// filled in by the offset-map overloads of normalize_confusables / unicode_normalize during the same pass.
+//
+// The map is a sorted list of runs. Each run repeats one unit a number of times: unchanged text is a
+// single run of 1 -> 1 byte units, and consecutive replacements of equal shape (e.g. a row of Cyrillic
+// letters, 2 -> 1 bytes each) share a run. A replaced unit is atomic: offsets inside it map to its start,
+// and span lookups widen to cover it. Lookups are a binary search over the runs in either direction.
+class OffsetMap {
+public:
+    // Output offset -> input offset (start of the replaced unit when inside one)
+    size_t to_input(size_t output_offset) const;
+    // Input offset -> output offset (start of the replacement when inside a replaced unit)
+    size_t to_output(size_t input_offset) const;
+
+    // Output byte span -> smallest input span that produced it
+    std::pair<size_t, size_t> to_input_span(size_t output_begin, size_t output_end) const;
+    // Input byte span -> smallest output span it produced
+    std::pair<size_t, size_t> to_output_span(size_t input_begin, size_t input_end) const;
+
+    size_t input_size() const { return input_size_; }
+    size_t output_size() const { return output_size_; }
+    size_t run_count() const { return runs_.size(); }
+
+    void clear();
+    // Appends length bytes that were copied through unchanged
+    void append_copy(size_t length);
+    // Appends input_length bytes that were replaced by output_length bytes
+    void append_replacement(size_t input_length, size_t output_length);
+
+    // Replaces the part of the map covering input [input_begin, input_end) with replacement, which maps the
+    // new text for that range. Both offsets must be unit boundaries (e.g. codepoint boundaries). Only the
+    // runs overlapping the range are rebuilt, but the runs after it are shifted, so the cost is linear in them.
+    void splice(size_t input_begin, size_t input_end, const OffsetMap& replacement);
+
+private:
+    struct Run {
+        size_t input_start;
+        size_t output_start;
+        uint32_t input_step;   // bytes per unit on the input side
+        uint32_t output_step;  // bytes per unit on the output side
+        bool replaced;
+    };
+
+    void append_units(uint32_t input_step, uint32_t output_step, size_t count, bool replaced);
+    // Number of units in runs[index], given the sizes of the map it belongs to
+    static size_t unit_count(const std::vector<Run>& runs, size_t index, size_t input_size, size_t output_size);
+    // Maps offset from one side to the other; round_up selects the end rather than the start of a unit
+    size_t map(size_t offset, bool from_output, bool round_up) const;
+
+    std::vector<Run> runs_;
+    size_t input_size_ = 0;
+    size_t output_size_ = 0;
+};
+
+} // namespace unicode_confusables
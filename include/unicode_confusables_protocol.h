@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace unicode_confusables {
+
+// Wire format of the normalization daemon (confusables_normalize --serve), shared by NormalizationServer and
+// NormalizationClient. Every message is a frame: a 10-byte header followed by payload_length bytes of payload.
+// Integers are little-endian.
+//
+//     request:  u32 payload_length | u32 request_id | u8 operation | u8 flags    | payload (UTF-8)
+//     response: u32 payload_length | u32 request_id | u8 status    | u8 reserved | payload
+//
+// Clients may pipeline any number of requests on a connection; responses come back in request order and
+// carry the request's id. Requests the server cannot decode are answered with an error status; a request payload
+// above MAX_PAYLOAD is answered with TOO_LARGE and the connection is closed. MAX_PAYLOAD does not bound responses:
+// normalization can expand text about tenfold (U+FDFA is 3 bytes and normalizes to 30), so a response can be
+// larger than any request, up to the 32-bit length field.
+namespace protocol {
+
+constexpr size_t HEADER_SIZE = 10;
+constexpr uint32_t MAX_PAYLOAD = 16u << 20;  // of a request
+
+enum class Operation : uint8_t {
+    PING = 0,                   // Echoes the payload
+    NORMALIZE_CONFUSABLES = 1,  // normalize_confusables, see the flags below
+    CONTAINS_CONFUSABLES = 2    // contains_confusables; the payload lists the confusables found, concatenated in
+                                // codepoint order (each is one codepoint)
+};
+
+// NORMALIZE_CONFUSABLES flags
+constexpr uint8_t FLAG_FOLD_CASE = 0x01;
+// Bits 4-6 pick a Unicode normalization applied first, with zero-width stripping, like the CLI's --normalize:
+// 0 none, 1 NFC, 2 NFD, 3 NFKC, 4 NFKD
+constexpr unsigned NORMALIZATION_SHIFT = 4;
+constexpr uint8_t NORMALIZATION_MASK = 0x70;
+
+enum class Status : uint8_t {
+    OK = 0,
+    BAD_REQUEST = 1,  // Unknown operation or flags
+    TOO_LARGE = 2,    // Payload above MAX_PAYLOAD
+    INTERNAL_ERROR = 3  // The server failed to process this request (e.g. out of memory); later requests are unaffected
+};
+
+struct FrameHeader {
+    uint32_t payload_length;
+    uint32_t id;
+    uint8_t code;   // Operation in requests, Status in responses
+    uint8_t flags;  // 0 in responses
+};
+
+struct Request {
+    Operation operation;
+    uint8_t flags;
+    std::string payload;
+};
+
+struct Response {
+    uint32_t id;
+    Status status;
+    std::string payload;
+};
+
+inline FrameHeader read_header(const char* data) {
+    auto u32 = [data](size_t at) {
+        const auto* p = reinterpret_cast<const unsigned char*>(data + at);
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 |
+               static_cast<uint32_t>(p[3]) << 24;
+    };
+    return FrameHeader{u32(0), u32(4), static_cast<uint8_t>(data[8]), static_cast<uint8_t>(data[9])};
+}
+
+// Appends one frame to out
+inline void append_frame(std::string& out, uint32_t id, uint8_t code, uint8_t flags, std::string_view payload) {
+    char header[HEADER_SIZE];
+    const uint32_t length = static_cast<uint32_t>(payload.size());
+    for (size_t i = 0; i < 4; ++i) {
+        header[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+        header[4 + i] = static_cast<char>((id >> (8 * i)) & 0xFF);
+    }
+    header[8] = static_cast<char>(code);
+    header[9] = static_cast<char>(flags);
+    out.append(header, HEADER_SIZE);
+    out.append(payload.data(), payload.size());
+}
+
+} // namespace protocol
+} // namespace unicode_confusables
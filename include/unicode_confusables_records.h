@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace unicode_confusables {
+
+namespace detail {
+struct RecordField;
+} // namespace detail
+
+enum class RecordFormat {
+    JSONL,  // One JSON object per line; fields are its top-level keys
+    CSV,    // RFC 4180, with a header record naming the columns
+    TSV     // Tab-separated, with a header record; fields cannot contain tabs or line breaks
+};
+
+// Rewrites selected string fields of structured records and copies everything else byte for byte: keys, numbers,
+// nested values, separators and unselected fields are never touched. Values are decoded before they reach the
+// caller (JSON escapes, CSV doubled quotes) and re-encoded afterwards, so a replacement that produces a quote,
+// comma or backslash cannot break the record. A field whose value comes back unchanged keeps its original bytes,
+// including its original escapes.
+//
+// CSV and TSV streams start with a header record, passed to read_header() first. Records are given without
+// their line terminator; a CSV record continues on the next line while record_complete() is false.
+class RecordFieldRewriter {
+public:
+    // Transforms a decoded field value into out (which starts empty)
+    using Transform = std::function<void(std::string_view value, std::string& out)>;
+
+    // fields names JSON keys or CSV/TSV columns; if empty, every string value (every column) is selected
+    RecordFieldRewriter(RecordFormat format, std::vector<std::string> fields);
+
+    RecordFormat format() const { return format_; }
+
+    // True if the stream still needs its header record (CSV and TSV, before read_header)
+    bool expects_header() const { return format_ != RecordFormat::JSONL && !header_read_; }
+
+    // Reads the column names; returns false if the header is malformed
+    bool read_header(std::string_view record);
+
+    // Requested fields that the header does not name (CSV and TSV)
+    std::vector<std::string> missing_fields() const;
+
+    // False while text ends inside a quoted CSV field, i.e. the record goes on after the next line break
+    bool record_complete(std::string_view text) const;
+
+    // Calls visit(value) with the decoded value of every selected field. Returns false if the record is malformed;
+    // fields before the error may have been visited.
+    bool visit(std::string_view record, const std::function<void(std::string_view value)>& visit);
+
+    // Appends record to out with every selected field replaced by its transform. Returns false if the record is
+    // malformed, in which case it is appended unchanged. Blank JSONL lines are copied as they are.
+    bool rewrite(std::string_view record, const Transform& transform, std::string& out);
+
+private:
+    using Field = detail::RecordField;
+
+    template <typename OnField>
+    bool scan(std::string_view record, OnField&& on_field);
+
+    bool selected(std::string_view name) const;
+    // Decoded value of field into value (a view of record, or of scratch_ if the field has escapes)
+    bool decode(std::string_view record, const Field& field, std::string_view& value);
+    // Appends the encoded replacement for the bytes of field
+    void encode(std::string_view value, const Field& field, std::string& out) const;
+
+    RecordFormat format_;
+    std::vector<std::string> fields_;  // sorted
+    bool header_read_ = false;
+    std::vector<std::string> columns_;
+    std::vector<bool> selected_columns_;
+    std::string scratch_;
+    std::string key_;
+    std::string transformed_;
+};
+
+} // namespace unicode_confusables
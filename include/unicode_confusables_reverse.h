@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace unicode_confusables {
+
+// The confusables that normalize to one canonical string: a read-only view of one row of the reverse table.
+// Entries are source codepoints in ascending order, and stay valid for the process lifetime.
+class ConfusableList {
+public:
+    using iterator = const char32_t*;
+
+    ConfusableList() = default;
+    ConfusableList(const char32_t* sources, size_t count) : sources_(sources), count_(count) {}
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    char32_t operator[](size_t index) const { return sources_[index]; }
+    iterator begin() const { return sources_; }
+    iterator end() const { return sources_ + count_; }
+
+private:
+    const char32_t* sources_ = nullptr;
+    size_t count_ = 0;
+};
+
+// Returns the confusables that normalize_confusables maps to exactly canonical (the reverse mapping), e.g.
+// confusables_of("a") includes Cyrillic 'а'. Empty if nothing maps to canonical.
+//
+// Only single-codepoint sources are listed: normalize_confusables looks codepoints up one at a time, so table
+// keys of several codepoints (an emoji followed by U+FE0F) never apply and have no reverse entry.
+//
+// The reverse table is derived from the normalization tables on first use (thread-safe, once per mode) into a
+// compact CSR layout: sorted canonical strings, each owning a contiguous range of one array of source codepoints.
+// Processes that never call this pay nothing for it.
+ConfusableList confusables_of(std::string_view canonical, bool fold_case = false);
+
+} // namespace unicode_confusables
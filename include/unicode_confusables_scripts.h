@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <unicode/uscript.h>
+
+namespace unicode_confusables {
+
+// A set of scripts, as used for UTS #39 mixed-script detection
+class ScriptSet {
+public:
+    static constexpr size_t WORDS = 4;
+
+    // The empty set
+    ScriptSet() = default;
+    // Bitset words indexed by UScriptCode
+    explicit ScriptSet(const uint64_t* words) {
+        for (size_t w = 0; w < WORDS; ++w) {
+            words_[w] = words[w];
+        }
+    }
+    // Every script: the set of Common and Inherited characters, and the resolved set of text made only of them
+    static ScriptSet all();
+
+    bool contains(UScriptCode script) const {
+        return script >= 0 && static_cast<size_t>(script) < WORDS * 64 && ((words_[script / 64] >> (script % 64)) & 1);
+    }
+    bool empty() const {
+        uint64_t any = 0;
+        for (size_t w = 0; w < WORDS; ++w) {
+            any |= words_[w];
+        }
+        return any == 0;
+    }
+    bool is_all() const;
+
+    // The scripts in the set, in code order (every script ICU knows for all())
+    std::vector<UScriptCode> scripts() const;
+
+    ScriptSet& operator&=(const ScriptSet& other) {
+        for (size_t w = 0; w < WORDS; ++w) {
+            words_[w] &= other.words_[w];
+        }
+        return *this;
+    }
+    bool operator==(const ScriptSet& other) const {
+        for (size_t w = 0; w < WORDS; ++w) {
+            if (words_[w] != other.words_[w]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator!=(const ScriptSet& other) const { return !(*this == other); }
+
+private:
+    uint64_t words_[WORDS] = {};
+};
+
+// UTS #39 restriction levels, from most to least restrictive. The identifier profile is not checked, so
+// UTS #39's Unrestricted level is never reported.
+enum class RestrictionLevel {
+    ASCII_ONLY,              // Only ASCII characters
+    SINGLE_SCRIPT,           // Non-empty resolved script set
+    HIGHLY_RESTRICTIVE,      // Latin plus Han with Hiragana and Katakana, Bopomofo or Hangul
+    MODERATELY_RESTRICTIVE,  // Latin plus one other script except Cyrillic, Greek and Cherokee
+    MINIMALLY_RESTRICTIVE    // Anything else
+};
+
+// Script extensions of cp, augmented as in UTS #39 (Han implies Han with Bopomofo, Japanese and Korean;
+// Hiragana and Katakana imply Japanese, Hangul Korean, Bopomofo Han with Bopomofo). Common and Inherited
+// characters belong to every script.
+ScriptSet script_set_of(char32_t cp);
+
+struct Analysis {
+    // Same as contains_confusables(input)
+    std::unordered_set<std::string> confusables;
+    // Intersection of the script sets of all codepoints (UTS #39 resolved script set); all() for empty input
+    ScriptSet resolved_scripts = ScriptSet::all();
+    RestrictionLevel restriction_level = RestrictionLevel::ASCII_ONLY;
+
+    // True if no single script covers the text (e.g. Latin mixed with Cyrillic)
+    bool mixed_script() const { return resolved_scripts.empty(); }
+};
+
+// Confusable detection and script classification in one pass over the UTF-8 input. Script sets come from a
+// per-codepoint table generated with the confusables tables, so each codepoint costs one table lookup and a
+// bitset AND on top of the confusable lookup, with no ICU calls. Ill-formed sequences read as U+FFFD.
+Analysis analyze(std::string_view input);
+
+} // namespace unicode_confusables
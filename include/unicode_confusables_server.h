@@ -0,0 +1,98 @@
+#pragma once
+#include "unicode_confusables_protocol.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace unicode_confusables {
+
+struct ServerOptions {
+    // Threads running normalization; 0 uses the hardware concurrency
+    size_t worker_threads = 0;
+    // Most requests of one connection handed to a worker as one batch
+    size_t max_batch = 256;
+    // A connection is not read while this many bytes of its responses wait to be written or are being computed.
+    // Approximate: batches still at the workers count with their request size, and normalization can expand text
+    // about tenfold, so up to that much more output can build up before reading stops.
+    size_t max_pending_output = 4u << 20;
+    // Permission bits of the socket file, applied before the server accepts connections; connecting needs write
+    // permission. The default admits only the owner.
+    unsigned socket_mode = 0600;
+};
+
+// Long-running normalization service on a Unix domain socket, speaking the framed protocol of
+// unicode_confusables_protocol.h (Linux only).
+//
+// One thread runs an epoll loop that accepts connections and reads and writes them without blocking. The
+// complete requests found in one read of a connection go to the worker threads as a single batch, so
+// pipelined requests are decoded, normalized and answered together and a busy connection still spreads over
+// the workers; each connection's responses are put back in request order before they are written.
+class NormalizationServer {
+public:
+    explicit NormalizationServer(const ServerOptions& options = ServerOptions());
+    ~NormalizationServer();
+
+    NormalizationServer(const NormalizationServer&) = delete;
+    NormalizationServer& operator=(const NormalizationServer&) = delete;
+
+    // Binds socket_path, replacing a stale socket file, and starts listening. Returns false with error() set.
+    bool listen(const std::string& socket_path);
+
+    // Serves until stop(); the socket file is removed on return. Returns false with error() set if the loop fails.
+    bool run();
+
+    // Makes run() return; safe to call from other threads and from signal handlers
+    void stop();
+
+    const std::string& error() const { return error_; }
+
+private:
+    struct Connection;
+    struct Batch {
+        uint64_t connection;
+        uint64_t sequence;
+        std::string requests;   // complete request frames
+        std::string responses;  // response frames, filled by a worker
+    };
+
+    void worker_loop();
+    void accept_connections();
+    void read_connection(uint64_t id, Connection& connection);
+    void write_connection(Connection& connection);
+    void deliver(Connection& connection, uint64_t sequence, std::string&& responses);
+    void collect_completed();
+    // Closes the connection once it has nothing left to do; returns true if it was closed
+    bool close_if_done(uint64_t id, Connection& connection);
+    void close_connection(uint64_t id);
+    void update_events(uint64_t id, Connection& connection);
+    void shutdown();
+
+    ServerOptions options_;
+    std::string socket_path_;
+    std::string error_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd: completed batches or stop()
+    std::atomic<bool> stopping_{false};
+
+    uint64_t next_connection_ = 2;  // epoll ids 0 and 1 are the listening socket and wake_fd_
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_;
+
+    std::vector<std::thread> workers_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_ready_;
+    std::deque<Batch> queue_;
+    bool workers_stopping_ = false;
+    std::mutex completed_mutex_;
+    std::vector<Batch> completed_;
+};
+
+} // namespace unicode_confusables
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unicode/uscript.h>
+
+namespace unicode_confusables {
+
+struct VariantOptions {
+    // Stop after this many variants (the canonical spelling counts as the first)
+    uint64_t max_count = std::numeric_limits<uint64_t>::max();
+    // Maximum number of look-alikes in one variant
+    size_t max_substitutions = std::numeric_limits<size_t>::max();
+    // If non-empty, only look-alikes in (or with script extensions including) one of these scripts are used.
+    // List USCRIPT_COMMON to allow digits and punctuation.
+    std::vector<UScriptCode> allowed_scripts;
+    // Expand through the case-folded tables, which adds case variants (see normalize_confusables)
+    bool fold_case = false;
+};
+
+// Enumerates the look-alike spellings of a term without materializing them. The term is normalized, and the
+// canonical form is rewritten piece by piece: each codepoint is either kept (if it normalizes to itself), or a run
+// of one or more codepoints is replaced by a confusable that normalizes to exactly that run (the reverse table, see
+// confusables_of; e.g. U+01F3 'ǳ' for "dz"). Every variant therefore normalizes to the same string as the term,
+// and every spelling that does so (within the limits below) is produced exactly once.
+//
+// Variants are numbered in a fixed order (0 is the canonical spelling itself, when it normalizes to itself) and
+// generated on demand from their number, so next() streams them, seek() skips ahead and variant_at() gives random
+// access for sampling, each in time linear in the term length. Counts saturate at UINT64_MAX; only that many variants are addressable.
+class VariantGenerator {
+public:
+    explicit VariantGenerator(std::string_view term, const VariantOptions& options = VariantOptions());
+
+    // Number of variants within the limits
+    uint64_t count() const { return count_; }
+
+    // Writes variant number index (< count()) to out
+    void variant_at(uint64_t index, std::string& out) const;
+
+    // Writes the next variant to out; returns false once all count() variants have been produced
+    bool next(std::string& out);
+
+    void seek(uint64_t index) { position_ = index; }
+    uint64_t position() const { return position_; }
+
+    // The canonical spelling the variants are derived from
+    const std::string& canonical() const { return canonical_; }
+
+private:
+    // A run of canonical codepoints [start, end) that the look-alikes options_[option_begin, option_end) replace
+    struct Run {
+        size_t end;
+        size_t option_begin;
+        size_t option_end;
+    };
+
+    // Number of ways to spell codepoints [position, end) with at most substitutions look-alikes
+    uint64_t completions(size_t position, size_t substitutions) const {
+        return completions_[position * (max_substitutions_ + 1) + substitutions];
+    }
+
+    std::string canonical_;
+    // Codepoint i of the canonical form is canonical_[offsets_[i], offsets_[i + 1]); the runs starting there are
+    // runs_[run_begin_[i], run_begin_[i + 1])
+    std::vector<size_t> offsets_;
+    std::vector<bool> keepable_;  // codepoint i normalizes to itself
+    std::vector<size_t> run_begin_;
+    std::vector<Run> runs_;
+    std::vector<std::string> options_;  // UTF-8
+    size_t max_substitutions_;
+    std::vector<uint64_t> completions_;
+    uint64_t count_;
+    uint64_t position_ = 0;
+};
+
+} // namespace unicode_confusables
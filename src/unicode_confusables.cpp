@@ -1,113 +1,343 @@
 #include "unicode_confusables.h"
 #include "unicode_confusables_data.h"
+#include "unicode_confusables_internal.h"
+#include "unicode_confusables_offsets.h"
 #include "utf8_utils.h"
+#include <cstring>
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
+#include <string_view>
+#include <unicode/bytestream.h>
+#include <unicode/edits.h>
+#include <unicode/uchar.h>
 #include <unicode/unistr.h>
+#include <unicode/utf8.h>
 #include <unicode/normalizer2.h>
 #include <unicode/errorcode.h>
 
 namespace unicode_confusables {
 
-// Helper function to strip zero-width characters from a normalized string
-static std::string strip_zero_width_chars(const icu::UnicodeString& normalized) {
-    UErrorCode setStatus = U_ZERO_ERROR;
-    icu::UnicodeSet zwSet(UNICODE_STRING_SIMPLE("[:Cf:]"), setStatus);
-    zwSet.freeze();
-    icu::UnicodeString filtered;
-    for (int32_t i = 0; i < normalized.length(); ) {
-        UChar32 cp = normalized.char32At(i);
-        if (!zwSet.contains(cp)) {
-            filtered.append(cp);
-        }
-        i += U16_LENGTH(cp);
-    }
-    std::string result;
-    filtered.toUTF8String(result);
-    return result;
-}
-
 // Returns the set of confusable Unicode characters found in the input string
-std::unordered_set<std::string> contains_confusables(const std::string& input) {
+std::unordered_set<std::string> contains_confusables(std::string_view input) {
     std::unordered_set<std::string> confusables_found;
-    icu::UnicodeString ustr = icu::UnicodeString::fromUTF8(input);
-    
-    for (int32_t i = 0; i < ustr.length(); ) {
-        char32_t cp = ustr.char32At(i);
-        std::string utf8_char = utf8_utils::codepoint_to_utf8(cp);
-        
-        if (CONFUSABLE_TO_CANONICAL.find(utf8_char) != CONFUSABLE_TO_CANONICAL.end()) {
+    std::string utf8_char;
+    detail::for_each_codepoint(input, [&](char32_t cp, size_t, size_t) {
+        if (detail::find_canonical(CONFUSABLE_TO_CANONICAL, cp, utf8_char)) {
             confusables_found.insert(utf8_char);
         }
-        
-        int32_t charLen = U16_LENGTH(cp);
-        i += charLen;
-    }
+    });
     return confusables_found;
 }
 
+// Feeds the canonical UTF-8 form of every codepoint to append(const char*, size_t)
+template <typename Append>
+static void normalize_confusables_impl(std::string_view input, bool fold_case, Append&& append) {
+    const auto& table = detail::canonical_table(fold_case);
+    std::string utf8_char;
+    detail::for_each_codepoint(input, [&](char32_t cp, size_t, size_t) {
+        const std::string* canonical = detail::find_canonical(table, cp, utf8_char);
+        const std::string& out = canonical ? *canonical : utf8_char;
+        append(out.data(), out.size());
+    });
+}
+
 // Returns a new string with confusable characters replaced by their canonical equivalents
-std::string normalize_confusables(const std::string& input) {
-    icu::UnicodeString ustr = icu::UnicodeString::fromUTF8(input);
+std::string normalize_confusables(std::string_view input, bool fold_case) {
     std::string result;
-    
-    for (int32_t i = 0; i < ustr.length(); ) {
-        char32_t cp = ustr.char32At(i);
-        std::string utf8_char = utf8_utils::codepoint_to_utf8(cp);
-        
-        auto it = CONFUSABLE_TO_CANONICAL.find(utf8_char);
-        if (it != CONFUSABLE_TO_CANONICAL.end()) {
-            result += it->second;
+    result.reserve(input.size());
+    normalize_confusables_impl(input, fold_case, [&](const char* data, size_t size) {
+        result.append(data, size);
+    });
+    return result;
+}
+
+std::string normalize_confusables(std::string_view input, bool fold_case, OffsetMap& offsets) {
+    offsets.clear();
+    std::string result;
+    result.reserve(input.size());
+    const auto& table = detail::canonical_table(fold_case);
+    std::string utf8_char;
+    detail::for_each_codepoint(input, [&](char32_t cp, size_t begin, size_t end) {
+        if (const std::string* canonical = detail::find_canonical(table, cp, utf8_char)) {
+            result += *canonical;
+            offsets.append_replacement(end - begin, canonical->size());
+        } else if (input.compare(begin, end - begin, utf8_char) == 0) {
+            result += utf8_char;
+            offsets.append_copy(end - begin);
         } else {
+            // Ill-formed sequence, decoded as U+FFFD
             result += utf8_char;
+            offsets.append_replacement(end - begin, utf8_char.size());
         }
-        
-        int32_t charLen = U16_LENGTH(cp);
-        i += charLen;
-    }
-    
+    });
     return result;
 }
 
-std::string unicode_normalize(const std::string& input, NormalizationType type, bool strip_zero_width) {
-    UErrorCode errorCode = U_ZERO_ERROR;
-    const icu::Normalizer2* normalizer = nullptr;
-    
-    // Get the appropriate normalizer based on the type
+size_t normalize_confusables_into(std::string_view input, char* output, size_t output_capacity, bool fold_case) {
+    size_t required = 0;
+    normalize_confusables_impl(input, fold_case, [&](const char* data, size_t size) {
+        if (required + size <= output_capacity) {
+            std::memcpy(output + required, data, size);
+        }
+        required += size;
+    });
+    return required;
+}
+
+template <typename Char>
+static std::unordered_set<std::basic_string<Char>> contains_confusables_wide(std::basic_string_view<Char> input) {
+    std::unordered_set<std::basic_string<Char>> confusables_found;
+    std::string utf8_char;
+    detail::for_each_codepoint(input, [&](char32_t cp, size_t begin, size_t end) {
+        if (detail::find_canonical(CONFUSABLE_TO_CANONICAL, cp, utf8_char)) {
+            confusables_found.emplace(input.substr(begin, end - begin));
+        }
+    });
+    return confusables_found;
+}
+
+template <typename Char>
+static std::basic_string<Char> normalize_confusables_wide(std::basic_string_view<Char> input, bool fold_case) {
+    std::basic_string<Char> result;
+    result.reserve(input.size());
+    const auto& table = detail::canonical_table(fold_case);
+    std::string utf8_char;
+    detail::for_each_codepoint(input, [&](char32_t cp, size_t, size_t) {
+        if (const std::string* canonical = detail::find_canonical(table, cp, utf8_char)) {
+            detail::append_utf8(result, *canonical);
+        } else {
+            detail::append_codepoint(result, cp);
+        }
+    });
+    return result;
+}
+
+std::unordered_set<std::u16string> contains_confusables(std::u16string_view input) {
+    return contains_confusables_wide(input);
+}
+
+std::unordered_set<std::u32string> contains_confusables(std::u32string_view input) {
+    return contains_confusables_wide(input);
+}
+
+std::u16string normalize_confusables(std::u16string_view input, bool fold_case) {
+    return normalize_confusables_wide(input, fold_case);
+}
+
+std::u32string normalize_confusables(std::u32string_view input, bool fold_case) {
+    return normalize_confusables_wide(input, fold_case);
+}
+
+size_t normalize_confusables_max_size(size_t input_size) {
+    return input_size * CONFUSABLE_MAX_EXPANSION;
+}
+
+bool normalize_confusables_inplace(char* buf, size_t& len, size_t& resume, bool fold_case) {
+    const auto& table = detail::canonical_table(fold_case);
+    static const std::string replacement_char = utf8_utils::codepoint_to_utf8(0xFFFD);
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(buf);
+    std::string utf8_char;
+    size_t read = 0;
+    size_t write = 0;
+    while (read < len) {
+        size_t start = read;
+        UChar32 cp;
+        U8_NEXT(s, read, len, cp);
+        size_t char_len = read - start;
+
+        // Ill-formed sequences become U+FFFD, like in normalize_confusables
+        const std::string* replacement = &replacement_char;
+        if (cp >= 0) {
+            replacement = detail::find_canonical(table, static_cast<char32_t>(cp), utf8_char);
+        }
+
+        if (replacement == nullptr) {
+            // Unmapped: shift the original bytes down over whatever earlier replacements freed up
+            if (write != start) {
+                std::memmove(buf + write, buf + start, char_len);
+            }
+            write += char_len;
+        } else if (replacement->size() <= char_len) {
+            std::memcpy(buf + write, replacement->data(), replacement->size());
+            write += replacement->size();
+        } else {
+            // Growing replacement: close the gap so the unprocessed rest follows the normalized prefix
+            if (write != start) {
+                std::memmove(buf + write, buf + start, len - start);
+                len -= start - write;
+            }
+            resume = write;
+            return false;
+        }
+    }
+    len = write;
+    resume = write;
+    return true;
+}
+
+static const icu::Normalizer2* get_normalizer(NormalizationType type, UErrorCode& errorCode) {
     switch (type) {
         case NormalizationType::NFC:
-            normalizer = icu::Normalizer2::getNFCInstance(errorCode);
-            break;
+            return icu::Normalizer2::getNFCInstance(errorCode);
         case NormalizationType::NFD:
-            normalizer = icu::Normalizer2::getNFDInstance(errorCode);
-            break;
+            return icu::Normalizer2::getNFDInstance(errorCode);
         case NormalizationType::NFKC:
-            normalizer = icu::Normalizer2::getNFKCInstance(errorCode);
-            break;
+            return icu::Normalizer2::getNFKCInstance(errorCode);
         case NormalizationType::NFKD:
-            normalizer = icu::Normalizer2::getNFKDInstance(errorCode);
-            break;
+            return icu::Normalizer2::getNFKDInstance(errorCode);
+    }
+    return nullptr;
+}
+
+// Normalizes UTF-8 directly (no UTF-16 round trip). ICU copies ill-formed bytes through unchanged, so a
+// second pass over the normalized bytes turns them into U+FFFD (as UnicodeString::fromUTF8 would) and drops
+// format characters if strip_zero_width is set. With offsets, ICU's edits are folded into the map on the way.
+static std::string unicode_normalize_impl(std::string_view input, NormalizationType type, bool strip_zero_width,
+                                          OffsetMap* offsets) {
+    if (offsets) {
+        offsets->clear();
     }
-    
+    auto fallback = [&]() {
+        if (offsets) {
+            offsets->clear();
+            offsets->append_copy(input.size());
+        }
+        return std::string(input); // fallback: return input if ICU fails
+    };
+
+    UErrorCode errorCode = U_ZERO_ERROR;
+    const icu::Normalizer2* normalizer = get_normalizer(type, errorCode);
     if (U_FAILURE(errorCode) || normalizer == nullptr) {
-        return input; // fallback: return input if ICU fails
+        return fallback();
     }
-    
-    icu::UnicodeString ustr = icu::UnicodeString::fromUTF8(input);
-    icu::UnicodeString normalized;
-    normalizer->normalize(ustr, normalized, errorCode);
+
+    std::string normalized;
+    normalized.reserve(input.size());
+    icu::StringByteSink<std::string> sink(&normalized);
+    icu::Edits edits;
+    normalizer->normalizeUTF8(0, icu::StringPiece(input.data(), static_cast<int32_t>(input.size())), sink,
+                              offsets ? &edits : nullptr, errorCode);
     if (U_FAILURE(errorCode)) {
-        return input;
+        return fallback();
     }
-    
-    if (strip_zero_width) {
-        return strip_zero_width_chars(normalized);
-    } else {
-        std::string result;
-        normalized.toUTF8String(result);
+
+    static const std::string replacement_char = utf8_utils::codepoint_to_utf8(0xFFFD);
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(normalized.data());
+    std::string result;
+    result.reserve(normalized.size());
+    // Post-processes normalized[begin, end); unchanged segments are byte-identical to the input and get
+    // per-codepoint offsets, changed ones become a single replacement of their input_length bytes
+    auto finish_segment = [&](size_t begin, size_t end, bool changed, size_t input_length) {
+        size_t result_start = result.size();
+        for (size_t i = begin; i < end; ) {
+            size_t start = i;
+            UChar32 cp;
+            U8_NEXT(s, i, end, cp);
+            size_t char_len = i - start;
+            if (cp < 0) {
+                result += replacement_char;
+                if (offsets && !changed) {
+                    offsets->append_replacement(char_len, replacement_char.size());
+                }
+            } else if (strip_zero_width && u_charType(cp) == U_FORMAT_CHAR) {
+                if (offsets && !changed) {
+                    offsets->append_replacement(char_len, 0);
+                }
+            } else {
+                result.append(normalized, start, char_len);
+                if (offsets && !changed) {
+                    offsets->append_copy(char_len);
+                }
+            }
+        }
+        if (offsets && changed) {
+            offsets->append_replacement(input_length, result.size() - result_start);
+        }
+    };
+
+    if (!offsets) {
+        finish_segment(0, normalized.size(), false, 0);
         return result;
     }
+    icu::Edits::Iterator it = edits.getFineIterator();
+    while (it.next(errorCode)) {
+        size_t begin = static_cast<size_t>(it.destinationIndex());
+        finish_segment(begin, begin + static_cast<size_t>(it.newLength()), it.hasChange(),
+                       static_cast<size_t>(it.oldLength()));
+    }
+    if (U_FAILURE(errorCode)) {
+        return fallback();
+    }
+    return result;
+}
+
+std::string unicode_normalize(std::string_view input, NormalizationType type, bool strip_zero_width) {
+    return unicode_normalize_impl(input, type, strip_zero_width, nullptr);
+}
+
+std::string unicode_normalize(std::string_view input, NormalizationType type, bool strip_zero_width,
+                              OffsetMap& offsets) {
+    return unicode_normalize_impl(input, type, strip_zero_width, &offsets);
+}
+
+// Normalizes UTF-16 text with ICU and appends the result to output in its encoding, dropping format characters
+// if strip_zero_width is set. Returns false if ICU fails.
+template <typename String>
+static bool unicode_normalize_utf16(const icu::UnicodeString& source, NormalizationType type, bool strip_zero_width,
+                                    String& output) {
+    UErrorCode errorCode = U_ZERO_ERROR;
+    const icu::Normalizer2* normalizer = get_normalizer(type, errorCode);
+    if (U_FAILURE(errorCode) || normalizer == nullptr) {
+        return false;
+    }
+    icu::UnicodeString normalized = normalizer->normalize(source, errorCode);
+    if (U_FAILURE(errorCode)) {
+        return false;
+    }
+    output.reserve(static_cast<size_t>(normalized.length()));
+    for (int32_t i = 0; i < normalized.length(); ) {
+        UChar32 cp = normalized.char32At(i);
+        i += U16_LENGTH(cp);
+        if (!strip_zero_width || u_charType(cp) != U_FORMAT_CHAR) {
+            detail::append_codepoint(output, static_cast<char32_t>(cp));
+        }
+    }
+    return true;
+}
+
+std::u16string unicode_normalize(std::u16string_view input, NormalizationType type, bool strip_zero_width) {
+    // Read-only alias of the input, unless unpaired surrogates have to become U+FFFD first
+    int32_t length = static_cast<int32_t>(input.size());
+    icu::UnicodeString source(false, input.data(), length);
+    int32_t index = 0;
+    for (UChar32 cp; index < length; ) {
+        U16_NEXT(input.data(), index, length, cp);
+        if (U_IS_SURROGATE(cp)) {
+            std::u16string sanitized;
+            sanitized.reserve(input.size());
+            detail::for_each_codepoint(input, [&](char32_t c, size_t, size_t) { detail::append_codepoint(sanitized, c); });
+            source = icu::UnicodeString(sanitized.data(), static_cast<int32_t>(sanitized.size()));
+            break;
+        }
+    }
+
+    std::u16string result;
+    if (!unicode_normalize_utf16(source, type, strip_zero_width, result)) {
+        return std::u16string(input);
+    }
+    return result;
+}
+
+std::u32string unicode_normalize(std::u32string_view input, NormalizationType type, bool strip_zero_width) {
+    // fromUTF32 replaces surrogates and out-of-range values with U+FFFD
+    icu::UnicodeString source = icu::UnicodeString::fromUTF32(reinterpret_cast<const UChar32*>(input.data()),
+                                                              static_cast<int32_t>(input.size()));
+    std::u32string result;
+    if (!unicode_normalize_utf16(source, type, strip_zero_width, result)) {
+        return std::u32string(input);
+    }
+    return result;
 }
 
 } // namespace unicode_confusables
@@ -0,0 +1,163 @@
+#include "unicode_confusables_blocklist.h"
+#include "unicode_confusables.h"
+#include "unicode_confusables_internal.h"
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+namespace unicode_confusables {
+
+BlocklistMatcher::BlocklistMatcher(const std::vector<std::string>& patterns, bool fold_case)
+    : fold_case_(fold_case) {
+    // Build the trie over canonical pattern bytes
+    std::vector<std::vector<std::pair<uint8_t, uint32_t>>> children(1);
+    std::vector<std::vector<uint32_t>> own_outputs(1);
+    auto child = [&](uint32_t state, uint8_t byte) -> uint32_t {
+        for (const auto& edge : children[state]) {
+            if (edge.first == byte) return edge.second;
+        }
+        return 0;
+    };
+
+    pattern_lengths_.reserve(patterns.size());
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        std::string canonical = normalize_confusables(patterns[i], fold_case);
+        pattern_lengths_.push_back(canonical.size());
+        if (canonical.empty()) continue;
+        max_pattern_length_ = std::max(max_pattern_length_, canonical.size());
+
+        uint32_t state = 0;
+        for (unsigned char byte : canonical) {
+            uint32_t next = child(state, byte);
+            if (next == 0) {
+                next = static_cast<uint32_t>(children.size());
+                children.emplace_back();
+                own_outputs.emplace_back();
+                children[state].emplace_back(byte, next);
+            }
+            state = next;
+        }
+        own_outputs[state].push_back(static_cast<uint32_t>(i));
+    }
+
+    // Breadth-first: fail links point at the longest proper suffix that is also a trie path,
+    // dictionary links at the nearest such suffix that ends a pattern
+    const size_t state_count = children.size();
+    fail_.assign(state_count, 0);
+    dict_link_.assign(state_count, 0);
+    std::deque<uint32_t> queue;
+    for (const auto& edge : children[0]) {
+        queue.push_back(edge.second);
+    }
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop_front();
+        for (const auto& edge : children[state]) {
+            uint32_t f = fail_[state];
+            while (f != 0 && child(f, edge.first) == 0) {
+                f = fail_[f];
+            }
+            uint32_t target = child(f, edge.first);
+            fail_[edge.second] = target;
+            dict_link_[edge.second] = own_outputs[target].empty() ? dict_link_[target] : target;
+            queue.push_back(edge.second);
+        }
+    }
+
+    // Flatten into the lookup arrays
+    root_next_.assign(256, 0);
+    for (const auto& edge : children[0]) {
+        root_next_[edge.first] = edge.second;
+    }
+    edge_begin_.reserve(state_count + 1);
+    output_begin_.reserve(state_count + 1);
+    for (size_t state = 0; state < state_count; ++state) {
+        auto& edges = children[state];
+        std::sort(edges.begin(), edges.end());
+        edge_begin_.push_back(static_cast<uint32_t>(edge_bytes_.size()));
+        for (const auto& edge : edges) {
+            edge_bytes_.push_back(edge.first);
+            edge_targets_.push_back(edge.second);
+        }
+        output_begin_.push_back(static_cast<uint32_t>(outputs_.size()));
+        outputs_.insert(outputs_.end(), own_outputs[state].begin(), own_outputs[state].end());
+    }
+    edge_begin_.push_back(static_cast<uint32_t>(edge_bytes_.size()));
+    output_begin_.push_back(static_cast<uint32_t>(outputs_.size()));
+}
+
+uint32_t BlocklistMatcher::next_state(uint32_t state, uint8_t byte) const {
+    for (;;) {
+        if (state == 0) {
+            return root_next_[byte];
+        }
+        auto first = edge_bytes_.begin() + edge_begin_[state];
+        auto last = edge_bytes_.begin() + edge_begin_[state + 1];
+        auto it = std::lower_bound(first, last, byte);
+        if (it != last && *it == byte) {
+            return edge_targets_[it - edge_bytes_.begin()];
+        }
+        state = fail_[state];
+    }
+}
+
+template <typename OnMatch>
+void BlocklistMatcher::scan(std::string_view text, OnMatch&& on_match) const {
+    if (outputs_.empty()) return;
+
+    const auto& table = detail::canonical_table(fold_case_);
+    // (canonical offset, original offset) where each recent codepoint starts: enough history to map
+    // the start of any match (at most max_pattern_length_ canonical bytes back) to the original input
+    std::deque<std::pair<size_t, size_t>> starts;
+    std::string utf8_char;
+    uint32_t state = 0;
+    size_t canonical_pos = 0;
+
+    detail::for_each_codepoint(text, [&](char32_t cp, size_t begin, size_t end) {
+        while (starts.size() > 1 && starts[1].first + max_pattern_length_ <= canonical_pos) {
+            starts.pop_front();
+        }
+        starts.emplace_back(canonical_pos, begin);
+
+        const std::string* canonical = detail::find_canonical(table, cp, utf8_char);
+        const std::string& bytes = canonical ? *canonical : utf8_char;
+        for (unsigned char byte : bytes) {
+            state = next_state(state, byte);
+            ++canonical_pos;
+            uint32_t out = output_begin_[state] != output_begin_[state + 1] ? state : dict_link_[state];
+            for (; out != 0; out = dict_link_[out]) {
+                for (uint32_t i = output_begin_[out]; i < output_begin_[out + 1]; ++i) {
+                    uint32_t pattern = outputs_[i];
+                    size_t match_start = canonical_pos - pattern_lengths_[pattern];
+                    // Last codepoint starting at or before the match start
+                    auto it = std::upper_bound(starts.begin(), starts.end(), match_start,
+                        [](size_t pos, const std::pair<size_t, size_t>& entry) { return pos < entry.first; });
+                    if (!on_match(BlocklistMatch{pattern, std::prev(it)->second, end})) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    });
+}
+
+std::vector<BlocklistMatch> BlocklistMatcher::find_all(std::string_view text) const {
+    std::vector<BlocklistMatch> matches;
+    scan(text, [&](const BlocklistMatch& match) {
+        matches.push_back(match);
+        return true;
+    });
+    return matches;
+}
+
+bool BlocklistMatcher::contains_any(std::string_view text) const {
+    bool found = false;
+    scan(text, [&](const BlocklistMatch&) {
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+} // namespace unicode_confusables
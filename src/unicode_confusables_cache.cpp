@@ -0,0 +1,273 @@
+#include "unicode_confusables_cache.h"
+#include "unicode_confusables.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <unicode/utf8.h>
+
+namespace unicode_confusables {
+
+namespace {
+
+constexpr size_t WAYS = 4;
+constexpr size_t SHARED_STRIPES = 16;
+
+enum class EntryKind : uint8_t {
+    Empty,
+    Normalize,
+    NormalizeFolded,
+    Contains,
+};
+
+struct CacheEntry {
+    uint64_t hash = 0;
+    EntryKind kind = EntryKind::Empty;
+    uint8_t key_size = 0;
+    uint8_t value_size = 0;
+    bool referenced = false;  // CLOCK bit, only used by the thread tier
+    char key[CACHE_MAX_INPUT_SIZE];
+    char value[CACHE_MAX_RESULT_SIZE];
+
+    bool matches(uint64_t h, EntryKind k, std::string_view input) const {
+        return hash == h && kind == k && key_size == input.size() &&
+               std::memcmp(key, input.data(), input.size()) == 0;
+    }
+
+    void assign(uint64_t h, EntryKind k, std::string_view input, std::string_view result) {
+        hash = h;
+        kind = k;
+        key_size = static_cast<uint8_t>(input.size());
+        value_size = static_cast<uint8_t>(result.size());
+        std::memcpy(key, input.data(), input.size());
+        std::memcpy(value, result.data(), result.size());
+    }
+
+    std::string_view result() const { return std::string_view(value, value_size); }
+};
+
+// Fixed-size set-associative table: each hash maps to one set of WAYS entries
+class EntrySet {
+public:
+    explicit EntrySet(size_t entries) : entries_(entries), hands_(entries / WAYS, 0) {}
+
+    CacheEntry* find(uint64_t hash, EntryKind kind, std::string_view input) {
+        CacheEntry* set = &entries_[set_index(hash) * WAYS];
+        for (size_t way = 0; way < WAYS; ++way) {
+            if (set[way].matches(hash, kind, input)) {
+                return &set[way];
+            }
+        }
+        return nullptr;
+    }
+
+    // CLOCK: skip (and clear) recently referenced entries, take the first empty or unreferenced one
+    CacheEntry& clock_victim(uint64_t hash) {
+        size_t index = set_index(hash);
+        CacheEntry* set = &entries_[index * WAYS];
+        uint8_t& hand = hands_[index];
+        for (;;) {
+            CacheEntry& candidate = set[hand];
+            hand = static_cast<uint8_t>((hand + 1) % WAYS);
+            if (candidate.kind == EntryKind::Empty || !candidate.referenced) {
+                return candidate;
+            }
+            candidate.referenced = false;
+        }
+    }
+
+    // FIFO within the set, for the shared tier where reads must not write
+    CacheEntry& fifo_victim(uint64_t hash) {
+        size_t index = set_index(hash);
+        uint8_t& hand = hands_[index];
+        CacheEntry& candidate = entries_[index * WAYS + hand];
+        hand = static_cast<uint8_t>((hand + 1) % WAYS);
+        return candidate;
+    }
+
+private:
+    size_t set_index(uint64_t hash) const { return static_cast<size_t>(hash >> 8) % hands_.size(); }
+
+    std::vector<CacheEntry> entries_;
+    std::vector<uint8_t> hands_;
+};
+
+// Counters are only written by their owning thread (plain load + store), and read by cache_stats()
+struct ThreadCounters {
+    std::atomic<uint64_t> thread_hits{0};
+    std::atomic<uint64_t> shared_hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> bypassed{0};
+};
+
+void bump(std::atomic<uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void add_to(CacheStats& stats, const ThreadCounters& counters) {
+    stats.thread_hits += counters.thread_hits.load(std::memory_order_relaxed);
+    stats.shared_hits += counters.shared_hits.load(std::memory_order_relaxed);
+    stats.misses += counters.misses.load(std::memory_order_relaxed);
+    stats.bypassed += counters.bypassed.load(std::memory_order_relaxed);
+}
+
+// Live threads' counters plus the totals of threads that have exited
+struct CounterRegistry {
+    std::mutex mutex;
+    std::vector<const ThreadCounters*> live;
+    CacheStats retired;
+};
+
+CounterRegistry& counter_registry() {
+    static CounterRegistry registry;
+    return registry;
+}
+
+struct ThreadTier {
+    EntrySet entries{CACHE_THREAD_ENTRIES};
+    ThreadCounters counters;
+
+    ThreadTier() {
+        CounterRegistry& registry = counter_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.live.push_back(&counters);
+    }
+
+    ~ThreadTier() {
+        CounterRegistry& registry = counter_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        add_to(registry.retired, counters);
+        registry.live.erase(std::find(registry.live.begin(), registry.live.end(), &counters));
+    }
+};
+
+ThreadTier& thread_tier() {
+    thread_local ThreadTier tier;
+    return tier;
+}
+
+struct SharedStripe {
+    std::shared_mutex mutex;
+    EntrySet entries{CACHE_SHARED_ENTRIES / SHARED_STRIPES};
+};
+
+std::array<SharedStripe, SHARED_STRIPES>& shared_tier() {
+    static std::array<SharedStripe, SHARED_STRIPES> stripes;
+    return stripes;
+}
+
+uint64_t hash_input(std::string_view input, EntryKind kind) {
+    uint64_t hash = std::hash<std::string_view>()(input);
+    return hash ^ (static_cast<uint64_t>(kind) * 0x9E3779B97F4A7C15ull);
+}
+
+// Returns true (after counting the bypass) if input is too long to be cached
+bool bypass(std::string_view input) {
+    if (input.size() <= CACHE_MAX_INPUT_SIZE) {
+        return false;
+    }
+    bump(thread_tier().counters.bypassed);
+    return true;
+}
+
+// Looks a cacheable input up in the thread tier, then the shared tier, and otherwise stores compute(input).
+// Calls on_result with the (possibly cached) serialized result.
+template <typename Compute, typename OnResult>
+void lookup(std::string_view input, EntryKind kind, Compute&& compute, OnResult&& on_result) {
+    ThreadTier& tier = thread_tier();
+    uint64_t hash = hash_input(input, kind);
+    if (CacheEntry* entry = tier.entries.find(hash, kind, input)) {
+        entry->referenced = true;
+        bump(tier.counters.thread_hits);
+        on_result(entry->result());
+        return;
+    }
+
+    SharedStripe& stripe = shared_tier()[hash % SHARED_STRIPES];
+    {
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+        if (CacheEntry* entry = stripe.entries.find(hash, kind, input)) {
+            tier.entries.clock_victim(hash).assign(hash, kind, input, entry->result());
+            bump(tier.counters.shared_hits);
+            on_result(entry->result());
+            return;
+        }
+    }
+
+    std::string result = compute(input);
+    if (result.size() > CACHE_MAX_RESULT_SIZE) {
+        bump(tier.counters.bypassed);
+        on_result(result);
+        return;
+    }
+    bump(tier.counters.misses);
+    tier.entries.clock_victim(hash).assign(hash, kind, input, result);
+    {
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        if (!stripe.entries.find(hash, kind, input)) {
+            stripe.entries.fifo_victim(hash).assign(hash, kind, input, result);
+        }
+    }
+    on_result(result);
+}
+
+// contains_confusables results are cached as the found codepoints back to back. Every one of them
+// occurs in the input, so the serialized form is never longer than the input itself.
+std::string serialize_confusables(std::string_view input) {
+    std::string serialized;
+    for (const auto& item : contains_confusables(input)) {
+        serialized += item;
+    }
+    return serialized;
+}
+
+std::unordered_set<std::string> deserialize_confusables(std::string_view serialized) {
+    std::unordered_set<std::string> result;
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(serialized.data());
+    for (size_t i = 0; i < serialized.size(); ) {
+        size_t start = i;
+        U8_FWD_1(s, i, serialized.size());
+        result.emplace(serialized.substr(start, i - start));
+    }
+    return result;
+}
+
+} // namespace
+
+std::string cached_normalize_confusables(std::string_view input, bool fold_case) {
+    if (bypass(input)) {
+        return normalize_confusables(input, fold_case);
+    }
+    std::string output;
+    lookup(input, fold_case ? EntryKind::NormalizeFolded : EntryKind::Normalize,
+        [fold_case](std::string_view in) { return normalize_confusables(in, fold_case); },
+        [&](std::string_view result) { output.assign(result.data(), result.size()); });
+    return output;
+}
+
+std::unordered_set<std::string> cached_contains_confusables(std::string_view input) {
+    if (bypass(input)) {
+        return contains_confusables(input);
+    }
+    std::unordered_set<std::string> output;
+    lookup(input, EntryKind::Contains, serialize_confusables,
+        [&](std::string_view result) { output = deserialize_confusables(result); });
+    return output;
+}
+
+CacheStats cache_stats() {
+    CounterRegistry& registry = counter_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    CacheStats stats = registry.retired;
+    for (const ThreadCounters* counters : registry.live) {
+        add_to(stats, *counters);
+    }
+    return stats;
+}
+
+} // namespace unicode_confusables
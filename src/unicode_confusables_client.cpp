@@ -0,0 +1,221 @@
+#include "unicode_confusables_client.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace unicode_confusables {
+
+NormalizationClient::~NormalizationClient() {
+    close();
+}
+
+bool NormalizationClient::connect(const std::string& socket_path) {
+    close();
+    sockaddr_un address;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        return fail("invalid socket path '" + socket_path + "'");
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return fail(std::string("socket: ") + std::strerror(errno));
+    }
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        return fail("connect " + socket_path + ": " + std::strerror(errno));
+    }
+    return true;
+}
+
+void NormalizationClient::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    output_.clear();
+    output_sent_ = 0;
+    input_.clear();
+    input_used_ = 0;
+    outstanding_ = 0;
+}
+
+bool NormalizationClient::fail(const std::string& message) {
+    error_ = message;
+    close();
+    return false;
+}
+
+bool NormalizationClient::round_trip(protocol::Operation operation, uint8_t flags, std::string_view payload,
+                                     protocol::Response& response) {
+    // The next response would belong to an earlier send()
+    if (outstanding_ != 0) {
+        error_ = "requests sent with send() are still outstanding";
+        return false;
+    }
+    const uint32_t id = send(operation, flags, payload);
+    if (!receive(response)) {
+        return false;
+    }
+    if (response.id != id) {
+        return fail("response id " + std::to_string(response.id) + " does not match request id " + std::to_string(id));
+    }
+    if (response.status != protocol::Status::OK) {
+        error_ = "server returned status " + std::to_string(static_cast<int>(response.status));
+        return false;
+    }
+    return true;
+}
+
+bool NormalizationClient::normalize_confusables(std::string_view input, std::string& out, bool fold_case) {
+    protocol::Response response;
+    if (!round_trip(protocol::Operation::NORMALIZE_CONFUSABLES, fold_case ? protocol::FLAG_FOLD_CASE : 0, input,
+                    response)) {
+        return false;
+    }
+    out = std::move(response.payload);
+    return true;
+}
+
+bool NormalizationClient::contains_confusables(std::string_view input, std::unordered_set<std::string>& out) {
+    protocol::Response response;
+    if (!round_trip(protocol::Operation::CONTAINS_CONFUSABLES, 0, input, response)) {
+        return false;
+    }
+    // The payload is a sequence of UTF-8 codepoints
+    out.clear();
+    for (size_t i = 0; i < response.payload.size();) {
+        const auto lead = static_cast<unsigned char>(response.payload[i]);
+        size_t length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        out.insert(response.payload.substr(i, length));
+        i += length;
+    }
+    return true;
+}
+
+uint32_t NormalizationClient::send(protocol::Operation operation, uint8_t flags, std::string_view payload) {
+    const uint32_t id = next_id_++;
+    ++outstanding_;
+    protocol::append_frame(output_, id, static_cast<uint8_t>(operation), flags, payload);
+    return id;
+}
+
+bool NormalizationClient::flush() {
+    while (output_sent_ < output_.size()) {
+        if (!pump()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NormalizationClient::receive(protocol::Response& response) {
+    for (;;) {
+        const size_t available = input_.size() - input_used_;
+        if (available >= protocol::HEADER_SIZE) {
+            // Responses are not bound by MAX_PAYLOAD: normalization can make them larger than the request
+            protocol::FrameHeader header = protocol::read_header(input_.data() + input_used_);
+            if (available >= protocol::HEADER_SIZE + header.payload_length) {
+                response.id = header.id;
+                response.status = static_cast<protocol::Status>(header.code);
+                response.payload.assign(input_.data() + input_used_ + protocol::HEADER_SIZE, header.payload_length);
+                input_used_ += protocol::HEADER_SIZE + header.payload_length;
+                --outstanding_;
+                if (input_used_ == input_.size()) {
+                    input_.clear();
+                    input_used_ = 0;
+                }
+                return true;
+            }
+        }
+        if (!pump()) {
+            return false;
+        }
+    }
+}
+
+bool NormalizationClient::call(const std::vector<protocol::Request>& requests, std::vector<protocol::Response>& responses) {
+    responses.resize(requests.size());
+    for (const auto& request : requests) {
+        send(request.operation, request.flags, request.payload);
+    }
+    for (auto& response : responses) {
+        if (!receive(response)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NormalizationClient::pump() {
+    if (fd_ < 0) {
+        return fail(error_.empty() ? "not connected" : error_);
+    }
+    pollfd descriptor{};
+    descriptor.fd = fd_;
+    descriptor.events = POLLIN;
+    if (output_sent_ < output_.size()) {
+        descriptor.events |= POLLOUT;
+    }
+    while (::poll(&descriptor, 1, -1) < 0) {
+        if (errno != EINTR) {
+            return fail(std::string("poll: ") + std::strerror(errno));
+        }
+    }
+
+    if (descriptor.revents & POLLOUT) {
+        while (output_sent_ < output_.size()) {
+            ssize_t n = ::send(fd_, output_.data() + output_sent_, output_.size() - output_sent_, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n > 0) {
+                output_sent_ += static_cast<size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                // The server has closed; what it answered before that can still be read
+                output_.clear();
+                output_sent_ = 0;
+                descriptor.revents |= POLLHUP;
+                break;
+            }
+        }
+        if (output_sent_ == output_.size()) {
+            output_.clear();
+            output_sent_ = 0;
+        }
+    }
+
+    if (descriptor.revents & (POLLIN | POLLHUP | POLLERR)) {
+        char buffer[1 << 16];
+        bool received = false;
+        for (;;) {
+            ssize_t n = ::recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (n > 0) {
+                input_.append(buffer, static_cast<size_t>(n));
+                received = true;
+                if (static_cast<size_t>(n) < sizeof(buffer)) {
+                    break;
+                }
+            } else if (n == 0) {
+                // Hand out responses that arrived just before the close first
+                if (received) {
+                    break;
+                }
+                return fail("connection closed by the server");
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else {
+                return fail(std::string("recv: ") + std::strerror(errno));
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace unicode_confusables
@@ -0,0 +1,308 @@
+#include "unicode_confusables_distance.h"
+#include "unicode_confusables_internal.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace unicode_confusables {
+
+namespace {
+
+using Word = uint64_t;
+constexpr size_t WORD_BITS = 64;
+constexpr Word HIGH_BIT = Word(1) << (WORD_BITS - 1);
+// Candidates compared side by side by confusable_distances; their columns are independent, so the lane loops
+// have no dependencies between iterations and pipeline (or vectorize) across lanes
+constexpr size_t LANES = 4;
+
+// Canonical codepoint of every ASCII codepoint in one mode, or 0 where the canonical form is longer
+struct AsciiCanonical {
+    char32_t codepoints[0x80];
+
+    explicit AsciiCanonical(bool fold_case) {
+        const detail::CanonicalTable& table = detail::canonical_table(fold_case);
+        std::string utf8_char;
+        for (char32_t cp = 0; cp < 0x80; ++cp) {
+            codepoints[cp] = cp;
+            if (const std::string* canonical = detail::find_canonical(table, cp, utf8_char)) {
+                std::u32string decoded;
+                detail::append_utf8(decoded, *canonical);
+                codepoints[cp] = decoded.size() == 1 ? decoded[0] : 0;
+            }
+        }
+    }
+};
+
+// Canonical codepoints of input (normalize_confusables, decoded) into out
+void canonicalize(std::string_view input, bool fold_case, std::u32string& out) {
+    static const AsciiCanonical ascii[2] = {AsciiCanonical(false), AsciiCanonical(true)};
+    const char32_t* ascii_canonical = ascii[fold_case].codepoints;
+    const detail::CanonicalTable& table = detail::canonical_table(fold_case);
+    std::string utf8_char;
+    out.clear();
+    detail::for_each_codepoint(input, [&](char32_t cp, size_t, size_t) {
+        // Most of the text: skip the hash lookup
+        if (cp < 0x80 && ascii_canonical[cp] != 0) {
+            out.push_back(ascii_canonical[cp]);
+        } else if (const std::string* canonical = detail::find_canonical(table, cp, utf8_char)) {
+            detail::append_utf8(out, *canonical);
+        } else {
+            out.push_back(cp);
+        }
+    });
+}
+
+size_t length_difference(size_t a, size_t b) {
+    return a > b ? a - b : b - a;
+}
+
+// Advances one 64-row block of the DP by one text codepoint (Myers 1999, block form). pv/mv hold the block's
+// vertical +1/-1 deltas, eq the rows whose pattern codepoint matches, hin the horizontal delta entering at the
+// top (the row above the block). Returns the horizontal delta leaving at out_bit.
+int advance_block(Word& pv, Word& mv, Word eq, int hin, Word out_bit) {
+    const Word hin_negative = hin < 0 ? 1 : 0;
+    const Word xv = eq | mv;
+    eq |= hin_negative;
+    const Word xh = (((eq & pv) + pv) ^ pv) | eq;
+    Word ph = mv | ~(xh | pv);
+    Word mh = pv & xh;
+    const int hout = ((ph & out_bit) != 0) - ((mh & out_bit) != 0);
+    ph = (ph << 1) | (hin > 0 ? 1 : 0);
+    mh = (mh << 1) | hin_negative;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return hout;
+}
+
+// The pattern side of the comparison: match masks per distinct codepoint, one word per 64 codepoints
+class Pattern {
+public:
+    explicit Pattern(std::u32string codepoints)
+        : length_(codepoints.size()), words_((codepoints.size() + WORD_BITS - 1) / WORD_BITS),
+          masks_(words_, 0) {
+        std::fill(std::begin(ascii_rows_), std::end(ascii_rows_), 0);
+        size_t rows = 1;  // row 0 matches nothing
+        for (size_t i = 0; i < length_; ++i) {
+            char32_t cp = codepoints[i];
+            uint32_t* row = nullptr;
+            if (cp < 0x80) {
+                row = &ascii_rows_[cp];
+            } else {
+                auto it = std::lower_bound(other_rows_.begin(), other_rows_.end(), std::make_pair(cp, uint32_t(0)));
+                if (it == other_rows_.end() || it->first != cp) {
+                    it = other_rows_.insert(it, std::make_pair(cp, uint32_t(0)));
+                }
+                row = &it->second;
+            }
+            if (*row == 0) {
+                *row = static_cast<uint32_t>(rows++);
+                masks_.resize(rows * words_, 0);
+            }
+            masks_[*row * words_ + i / WORD_BITS] |= Word(1) << (i % WORD_BITS);
+        }
+    }
+
+    size_t length() const { return length_; }
+    size_t words() const { return words_; }
+
+    // Match mask of cp (words() words)
+    const Word* match(char32_t cp) const {
+        uint32_t row = 0;
+        if (cp < 0x80) {
+            row = ascii_rows_[cp];
+        } else {
+            auto it = std::lower_bound(other_rows_.begin(), other_rows_.end(), std::make_pair(cp, uint32_t(0)));
+            if (it != other_rows_.end() && it->first == cp) {
+                row = it->second;
+            }
+        }
+        return &masks_[row * words_];
+    }
+
+    // Distance limit for a text of length n: past max(length, n) nothing can exceed it, which keeps limit + 1 finite
+    size_t limit(size_t n, size_t max_k) const {
+        return std::min(max_k, std::max(length_, n));
+    }
+
+    size_t distance(const std::u32string& text, size_t max_k) const {
+        const size_t n = text.size();
+        const size_t k = limit(n, max_k);
+        if (length_difference(length_, n) > k) {
+            return k + 1;
+        }
+        if (length_ == 0 || n == 0) {
+            return std::max(length_, n);
+        }
+        return words_ == 1 ? distance_word(text, k) : distance_blocks(text, k);
+    }
+
+    void distances(const std::vector<std::string_view>& candidates, size_t max_k, bool fold_case,
+                   std::vector<size_t>& results) const;
+
+private:
+    Word last_bit() const { return Word(1) << ((length_ - 1) % WORD_BITS); }
+
+    // Pattern of up to 64 codepoints: the whole column is one word
+    size_t distance_word(const std::u32string& text, size_t k) const {
+        const size_t n = text.size();
+        const Word out_bit = last_bit();
+        Word pv = ~Word(0);
+        Word mv = 0;
+        size_t score = length_;
+        for (size_t j = 0; j < n; ++j) {
+            score += advance_block(pv, mv, *match(text[j]), 1, out_bit);
+            // The last row can drop by at most one per remaining column
+            if (score > k + (n - j - 1)) {
+                return k + 1;
+            }
+        }
+        return score;
+    }
+
+    // Longer patterns, banded: at column j only rows up to j + k can stay within k, so blocks below that are
+    // not computed until the band reaches them. A block joins with vertical deltas of +1, an overestimate only
+    // for cells already above k.
+    size_t distance_blocks(const std::u32string& text, size_t k) const {
+        const size_t n = text.size();
+        std::vector<Word> pv;
+        std::vector<Word> mv;
+        // Score of each active block's bottom row (row length_ for the last block)
+        std::vector<size_t> scores;
+        pv.reserve(words_);
+        mv.reserve(words_);
+        scores.reserve(words_);
+        for (size_t j = 0; j < n; ++j) {
+            const size_t needed = std::min(words_, (j + k) / WORD_BITS + 1);
+            while (scores.size() < needed) {
+                size_t b = scores.size();
+                size_t rows = b + 1 == words_ ? length_ - b * WORD_BITS : WORD_BITS;
+                scores.push_back((b == 0 ? j : scores[b - 1]) + rows);
+                pv.push_back(~Word(0));
+                mv.push_back(0);
+            }
+            const Word* eq = match(text[j]);
+            int h = 1;
+            for (size_t b = 0; b < scores.size(); ++b) {
+                h = advance_block(pv[b], mv[b], eq[b], h, b + 1 == words_ ? last_bit() : HIGH_BIT);
+                scores[b] += h;
+            }
+            if (scores.size() == words_ && scores.back() > k + (n - j - 1)) {
+                return k + 1;
+            }
+        }
+        // The length check guarantees the band reached the last row
+        return scores.back() <= k ? scores.back() : k + 1;
+    }
+
+    size_t length_;
+    size_t words_;
+    // Row r of the match masks is masks_[r * words_, (r + 1) * words_)
+    std::vector<Word> masks_;
+    uint32_t ascii_rows_[0x80];
+    std::vector<std::pair<char32_t, uint32_t>> other_rows_;  // sorted by codepoint
+};
+
+// Single-word patterns against a stream of candidates, LANES at a time. A lane that finishes (or gives up past
+// the limit) loads the next candidate immediately, so one long candidate does not hold back the others.
+void Pattern::distances(const std::vector<std::string_view>& candidates, size_t max_k, bool fold_case,
+                        std::vector<size_t>& results) const {
+    const Word out_bit = last_bit();
+    std::u32string texts[LANES];
+    size_t index[LANES] = {};
+    size_t position[LANES] = {};
+    size_t limits[LANES] = {};
+    size_t scores[LANES] = {};
+    Word pv[LANES] = {};
+    Word mv[LANES] = {};
+    bool active[LANES] = {};
+    size_t next = 0;
+
+    // Starts the next candidate that needs a comparison on lane l, settling trivial ones on the way
+    auto load = [&](size_t l) {
+        while (next < candidates.size()) {
+            size_t i = next++;
+            canonicalize(candidates[i], fold_case, texts[l]);
+            const size_t n = texts[l].size();
+            const size_t k = limit(n, max_k);
+            if (length_difference(length_, n) > k) {
+                results[i] = k + 1;
+            } else if (n == 0) {
+                results[i] = length_;
+            } else {
+                index[l] = i;
+                position[l] = 0;
+                limits[l] = k;
+                scores[l] = length_;
+                pv[l] = ~Word(0);
+                mv[l] = 0;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    size_t running = 0;
+    for (size_t l = 0; l < LANES; ++l) {
+        active[l] = load(l);
+        running += active[l];
+    }
+    while (running > 0) {
+        Word eq[LANES];
+        for (size_t l = 0; l < LANES; ++l) {
+            eq[l] = active[l] ? *match(texts[l][position[l]]) : 0;
+        }
+        int delta[LANES];
+        for (size_t l = 0; l < LANES; ++l) {
+            delta[l] = advance_block(pv[l], mv[l], eq[l], 1, out_bit);
+        }
+        for (size_t l = 0; l < LANES; ++l) {
+            if (!active[l]) {
+                continue;
+            }
+            scores[l] += delta[l];
+            const size_t remaining = texts[l].size() - ++position[l];
+            bool over = scores[l] > limits[l] + remaining;
+            if (over || remaining == 0) {
+                results[index[l]] = over ? limits[l] + 1 : scores[l];
+                if (!load(l)) {
+                    active[l] = false;
+                    --running;
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+size_t confusable_distance(std::string_view a, std::string_view b, size_t max_k, bool fold_case) {
+    std::u32string first;
+    std::u32string second;
+    canonicalize(a, fold_case, first);
+    canonicalize(b, fold_case, second);
+    // Levenshtein distance is symmetric; the shorter string as the pattern needs fewer words per column
+    if (first.size() > second.size()) {
+        first.swap(second);
+    }
+    return Pattern(std::move(first)).distance(second, max_k);
+}
+
+std::vector<size_t> confusable_distances(std::string_view query, const std::vector<std::string_view>& candidates,
+                                         size_t max_k, bool fold_case) {
+    std::u32string codepoints;
+    canonicalize(query, fold_case, codepoints);
+    const Pattern pattern(std::move(codepoints));
+    std::vector<size_t> results(candidates.size());
+    if (pattern.words() == 1) {
+        pattern.distances(candidates, max_k, fold_case, results);
+    } else {
+        std::u32string text;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            canonicalize(candidates[i], fold_case, text);
+            results[i] = pattern.distance(text, max_k);
+        }
+    }
+    return results;
+}
+
+} // namespace unicode_confusables
@@ -0,0 +1,52 @@
+#include "unicode_confusables_incremental.h"
+#include "unicode_confusables.h"
+#include <algorithm>
+#include <unicode/utf8.h>
+
+namespace unicode_confusables {
+
+IncrementalNormalizer::IncrementalNormalizer(std::string_view text, bool fold_case) : fold_case_(fold_case) {
+    assign(text);
+}
+
+void IncrementalNormalizer::assign(std::string_view text) {
+    input_.assign(text.data(), text.size());
+    output_ = normalize_confusables(input_, fold_case_, offsets_);
+}
+
+NormalizationPatch IncrementalNormalizer::replace(size_t begin, size_t end, std::string_view text) {
+    end = std::min(end, input_.size());
+    begin = std::min(begin, end);
+
+    // A byte that is not a trail byte always starts a new sequence, whatever precedes it. The window starts at
+    // such a byte strictly before the edit (which stays in place) and ends at one at or after it, so the
+    // decoder splits the text outside the window exactly as before.
+    size_t window_begin = begin;
+    while (window_begin > 0) {
+        --window_begin;
+        if (!U8_IS_TRAIL(input_[window_begin])) {
+            break;
+        }
+    }
+    size_t window_end = end;
+    while (window_end < input_.size() && U8_IS_TRAIL(input_[window_end])) {
+        ++window_end;
+    }
+
+    std::string window;
+    window.reserve((begin - window_begin) + text.size() + (window_end - end));
+    window.append(input_, window_begin, begin - window_begin);
+    window.append(text.data(), text.size());
+    window.append(input_, end, window_end - end);
+    OffsetMap window_offsets;
+    std::string normalized = normalize_confusables(window, fold_case_, window_offsets);
+
+    size_t output_begin = offsets_.to_output(window_begin);
+    size_t output_end = offsets_.to_output(window_end);
+    input_.replace(begin, end - begin, text.data(), text.size());
+    output_.replace(output_begin, output_end - output_begin, normalized);
+    offsets_.splice(window_begin, window_end, window_offsets);
+    return {output_begin, output_end - output_begin, normalized.size()};
+}
+
+} // namespace unicode_confusables
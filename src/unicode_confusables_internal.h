@@ -0,0 +1,95 @@
+#pragma once
+// Helpers shared by the library's translation units; not part of the public API.
+#include "unicode_confusables_data.h"
+#include "utf8_utils.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unicode/utf16.h>
+#include <unicode/utf8.h>
+
+namespace unicode_confusables {
+namespace detail {
+
+using CanonicalTable = std::unordered_map<std::string, std::string>;
+
+// Table used by normalize_confusables for the given mode
+inline const CanonicalTable& canonical_table(bool fold_case) {
+    return fold_case ? CONFUSABLE_TO_CANONICAL_FOLDED : CONFUSABLE_TO_CANONICAL;
+}
+
+// Calls fn(cp, begin, end) for every codepoint of the UTF-8 input, where [begin, end) is its byte range,
+// without transcoding the input. Ill-formed sequences decode to U+FFFD, same as icu::UnicodeString::fromUTF8.
+// If fn returns bool, returning false stops the iteration.
+template <typename Fn>
+inline void for_each_codepoint(std::string_view input, Fn&& fn) {
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(input.data());
+    const size_t length = input.size();
+    for (size_t i = 0; i < length; ) {
+        size_t begin = i;
+        UChar32 cp;
+        U8_NEXT_OR_FFFD(s, i, length, cp);
+        if constexpr (std::is_same_v<decltype(fn(char32_t(), size_t(), size_t())), bool>) {
+            if (!fn(static_cast<char32_t>(cp), begin, i)) {
+                return;
+            }
+        } else {
+            fn(static_cast<char32_t>(cp), begin, i);
+        }
+    }
+}
+
+// Calls fn(cp, begin, end) for every codepoint of the UTF-16 input, where [begin, end) is its code unit range.
+// Unpaired surrogates decode to U+FFFD, as they would after transcoding to UTF-8.
+template <typename Fn>
+inline void for_each_codepoint(std::u16string_view input, Fn&& fn) {
+    const char16_t* s = input.data();
+    const size_t length = input.size();
+    for (size_t i = 0; i < length; ) {
+        size_t begin = i;
+        UChar32 cp;
+        U16_NEXT_OR_FFFD(s, i, length, cp);
+        fn(static_cast<char32_t>(cp), begin, i);
+    }
+}
+
+// Same for UTF-32; surrogates and values above U+10FFFF decode to U+FFFD.
+template <typename Fn>
+inline void for_each_codepoint(std::u32string_view input, Fn&& fn) {
+    for (size_t i = 0; i < input.size(); ++i) {
+        char32_t cp = input[i];
+        fn(cp > 0x10FFFF || U_IS_SURROGATE(cp) ? char32_t(0xFFFD) : cp, i, i + 1);
+    }
+}
+
+inline void append_codepoint(std::u16string& output, char32_t cp) {
+    if (cp <= 0xFFFF) {
+        output.push_back(static_cast<char16_t>(cp));
+    } else {
+        output.push_back(static_cast<char16_t>(U16_LEAD(cp)));
+        output.push_back(static_cast<char16_t>(U16_TRAIL(cp)));
+    }
+}
+
+inline void append_codepoint(std::u32string& output, char32_t cp) {
+    output.push_back(cp);
+}
+
+// Appends well-formed UTF-8 (e.g. a table value) to a UTF-16 or UTF-32 string
+template <typename String>
+inline void append_utf8(String& output, std::string_view utf8) {
+    for_each_codepoint(utf8, [&](char32_t cp, size_t, size_t) { append_codepoint(output, cp); });
+}
+
+// Returns the canonical UTF-8 for cp, or nullptr if cp maps to itself. utf8_char receives cp's own UTF-8 either way.
+inline const std::string* find_canonical(const CanonicalTable& table, char32_t cp, std::string& utf8_char) {
+    utf8_char = utf8_utils::codepoint_to_utf8(cp);
+    auto it = table.find(utf8_char);
+    return it != table.end() ? &it->second : nullptr;
+}
+
+} // namespace detail
+} // namespace unicode_confusables
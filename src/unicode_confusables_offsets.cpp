@@ -0,0 +1,184 @@
+#include "unicode_confusables_offsets.h"
+#include <algorithm>
+
+namespace unicode_confusables {
+
+void OffsetMap::clear() {
+    runs_.clear();
+    input_size_ = 0;
+    output_size_ = 0;
+}
+
+void OffsetMap::append_units(uint32_t input_step, uint32_t output_step, size_t count, bool replaced) {
+    if (count == 0 || (input_step == 0 && output_step == 0)) {
+        return;
+    }
+    // Extend the previous run if it repeats the same unit
+    if (runs_.empty() || runs_.back().replaced != replaced || runs_.back().input_step != input_step ||
+        runs_.back().output_step != output_step) {
+        runs_.push_back({input_size_, output_size_, input_step, output_step, replaced});
+    }
+    input_size_ += count * input_step;
+    output_size_ += count * output_step;
+}
+
+void OffsetMap::append_copy(size_t length) {
+    append_units(1, 1, length, false);
+}
+
+void OffsetMap::append_replacement(size_t input_length, size_t output_length) {
+    append_units(static_cast<uint32_t>(input_length), static_cast<uint32_t>(output_length), 1, true);
+}
+
+size_t OffsetMap::unit_count(const std::vector<Run>& runs, size_t index, size_t input_size, size_t output_size) {
+    const Run& run = runs[index];
+    if (run.input_step != 0) {
+        size_t end = index + 1 < runs.size() ? runs[index + 1].input_start : input_size;
+        return (end - run.input_start) / run.input_step;
+    }
+    size_t end = index + 1 < runs.size() ? runs[index + 1].output_start : output_size;
+    return (end - run.output_start) / run.output_step;
+}
+
+void OffsetMap::splice(size_t input_begin, size_t input_end, const OffsetMap& replacement) {
+    // Only the runs that can overlap the edit are rebuilt: the run that may straddle input_begin through the
+    // last one starting at or before input_end. Runs before them stay as they are, runs after them only move.
+    size_t first = std::lower_bound(runs_.begin(), runs_.end(), input_begin,
+                                    [](const Run& run, size_t value) { return run.input_start < value; }) -
+                   runs_.begin();
+    if (first > 0) {
+        --first;
+    }
+    size_t last = std::upper_bound(runs_.begin(), runs_.end(), input_end,
+                                   [](size_t value, const Run& run) { return value < run.input_start; }) -
+                  runs_.begin();
+
+    // Rebuilt runs go to middle, seeded with the untouched run before them so that a unit of the same shape
+    // extends it, as a full pass would
+    OffsetMap middle;
+    const size_t seeded = first > 0 ? 1 : 0;
+    if (seeded) {
+        middle.runs_.push_back(runs_[first - 1]);
+    }
+    if (first < runs_.size()) {
+        middle.input_size_ = runs_[first].input_start;
+        middle.output_size_ = runs_[first].output_start;
+    }
+
+    // Units starting before input_begin
+    if (first < runs_.size() && runs_[first].input_start < input_begin) {
+        const Run& run = runs_[first];
+        size_t count = unit_count(runs_, first, input_size_, output_size_);
+        if (run.input_step != 0) {
+            count = std::min(count, (input_begin - run.input_start) / run.input_step);
+        }
+        middle.append_units(run.input_step, run.output_step, count, run.replaced);
+    }
+    for (size_t i = 0; i < replacement.runs_.size(); ++i) {
+        const Run& run = replacement.runs_[i];
+        middle.append_units(run.input_step, run.output_step,
+                            unit_count(replacement.runs_, i, replacement.input_size_, replacement.output_size_),
+                            run.replaced);
+    }
+    // Units starting at or after input_end
+    for (size_t index = first; index < last; ++index) {
+        const Run& run = runs_[index];
+        size_t count = unit_count(runs_, index, input_size_, output_size_);
+        size_t run_end = run.input_start + count * run.input_step;
+        if (run.input_step == 0 ? run.input_start <= input_end : run_end <= input_end) {
+            continue;
+        }
+        if (run.input_start < input_end) {
+            count -= (input_end - run.input_start) / run.input_step;
+        }
+        middle.append_units(run.input_step, run.output_step, count, run.replaced);
+    }
+
+    // The runs after the edit move by the size change; the first of them joins the last rebuilt run if it
+    // repeats the same unit
+    size_t tail = last;
+    if (last < runs_.size()) {
+        const Run& next = runs_[last];
+        const size_t old_input = next.input_start;
+        const size_t old_output = next.output_start;
+        if (!middle.runs_.empty() && middle.runs_.back().replaced == next.replaced &&
+            middle.runs_.back().input_step == next.input_step && middle.runs_.back().output_step == next.output_step) {
+            ++tail;
+        }
+        for (size_t i = tail; i < runs_.size(); ++i) {
+            runs_[i].input_start = runs_[i].input_start - old_input + middle.input_size_;
+            runs_[i].output_start = runs_[i].output_start - old_output + middle.output_size_;
+        }
+        input_size_ = input_size_ - old_input + middle.input_size_;
+        output_size_ = output_size_ - old_output + middle.output_size_;
+    } else {
+        input_size_ = middle.input_size_;
+        output_size_ = middle.output_size_;
+    }
+
+    // Replace runs [first - seeded, tail) with middle's
+    const size_t at = first - seeded;
+    const size_t old_count = tail - at;
+    const size_t new_count = middle.runs_.size();
+    if (new_count > old_count) {
+        runs_.insert(runs_.begin() + tail, middle.runs_.begin() + old_count, middle.runs_.end());
+    } else {
+        runs_.erase(runs_.begin() + at + new_count, runs_.begin() + tail);
+    }
+    std::copy_n(middle.runs_.begin(), std::min(old_count, new_count), runs_.begin() + at);
+}
+
+size_t OffsetMap::map(size_t offset, bool from_output, bool round_up) const {
+    size_t from_size = from_output ? output_size_ : input_size_;
+    size_t to_size = from_output ? input_size_ : output_size_;
+    auto from_start = [from_output](const Run& run) { return from_output ? run.output_start : run.input_start; };
+
+    if (offset == 0 && round_up) {
+        return 0;
+    }
+    if (offset >= from_size) {
+        if (!round_up || runs_.empty()) {
+            return to_size;
+        }
+        offset = from_size;
+    }
+
+    // Start offsets bind to the run beginning there (skipping runs that are empty on this side), end offsets
+    // to the run ending there, so a span never picks up text deleted just outside it
+    auto it = round_up
+        ? std::lower_bound(runs_.begin(), runs_.end(), offset,
+              [&](const Run& run, size_t value) { return from_start(run) < value; })
+        : std::upper_bound(runs_.begin(), runs_.end(), offset,
+              [&](size_t value, const Run& run) { return value < from_start(run); });
+    const Run& run = *(it - 1);
+
+    size_t from_step = from_output ? run.output_step : run.input_step;
+    size_t to_step = from_output ? run.input_step : run.output_step;
+    size_t to_start = from_output ? run.input_start : run.output_start;
+    size_t delta = offset - from_start(run);
+    size_t unit = delta / from_step;
+    if (round_up && delta % from_step != 0) {
+        ++unit;
+    }
+    return std::min(to_start + unit * to_step, to_size);
+}
+
+size_t OffsetMap::to_input(size_t output_offset) const {
+    return map(output_offset, true, false);
+}
+
+size_t OffsetMap::to_output(size_t input_offset) const {
+    return map(input_offset, false, false);
+}
+
+std::pair<size_t, size_t> OffsetMap::to_input_span(size_t output_begin, size_t output_end) const {
+    size_t begin = map(output_begin, true, false);
+    return {begin, std::max(begin, map(output_end, true, true))};
+}
+
+std::pair<size_t, size_t> OffsetMap::to_output_span(size_t input_begin, size_t input_end) const {
+    size_t begin = map(input_begin, false, false);
+    return {begin, std::max(begin, map(input_end, false, true))};
+}
+
+} // namespace unicode_confusables
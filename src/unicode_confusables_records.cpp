@@ -0,0 +1,485 @@
+#include "unicode_confusables_records.h"
+#include "utf8_utils.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace unicode_confusables {
+
+namespace detail {
+
+// A field value inside a record: [begin, end) are its bytes, without the surrounding quotes if quoted
+struct RecordField {
+    size_t begin;
+    size_t end;
+    bool quoted;
+    bool escaped;  // contains JSON escapes or CSV doubled quotes
+    size_t column;
+};
+
+} // namespace detail
+
+namespace {
+
+using Field = detail::RecordField;
+
+size_t skip_whitespace(std::string_view s, size_t pos) {
+    while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' || s[pos] == '\r')) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Index of the quote closing the JSON string that starts at pos (after the opening quote), or npos
+size_t find_json_string_end(std::string_view s, size_t pos, bool& escaped) {
+    escaped = false;
+    for (;;) {
+        pos = s.find_first_of("\"\\", pos);
+        if (pos == std::string_view::npos || s[pos] == '"') {
+            return pos;
+        }
+        escaped = true;
+        pos += 2;
+        if (pos > s.size()) {
+            return std::string_view::npos;
+        }
+    }
+}
+
+// Position after the JSON value starting at pos, or npos. Only strings and nesting are checked; scalars are
+// taken as they are, since they are copied verbatim.
+size_t skip_json_value(std::string_view s, size_t pos) {
+    bool escaped = false;
+    if (s[pos] == '"') {
+        size_t end = find_json_string_end(s, pos + 1, escaped);
+        return end == std::string_view::npos ? end : end + 1;
+    }
+    if (s[pos] == '{' || s[pos] == '[') {
+        std::vector<char> closers;
+        for (; pos < s.size(); ++pos) {
+            char c = s[pos];
+            if (c == '"') {
+                pos = find_json_string_end(s, pos + 1, escaped);
+                if (pos == std::string_view::npos) {
+                    return pos;
+                }
+            } else if (c == '{' || c == '[') {
+                closers.push_back(c == '{' ? '}' : ']');
+            } else if (c == '}' || c == ']') {
+                if (c != closers.back()) {
+                    return std::string_view::npos;
+                }
+                closers.pop_back();
+                if (closers.empty()) {
+                    return pos + 1;
+                }
+            }
+        }
+        return std::string_view::npos;
+    }
+    size_t start = pos;
+    while (pos < s.size() && s[pos] != ',' && s[pos] != '}' && s[pos] != ']' && s[pos] != ' ' && s[pos] != '\t' &&
+           s[pos] != '\r' && s[pos] != '\n') {
+        ++pos;
+    }
+    return pos == start ? std::string_view::npos : pos;
+}
+
+// Calls on_field(key, key_escaped, value) for every string value of the top-level object in line.
+// A blank line has no fields.
+template <typename OnField>
+bool scan_json_object(std::string_view line, OnField&& on_field) {
+    size_t pos = skip_whitespace(line, 0);
+    if (pos == line.size()) {
+        return true;
+    }
+    if (line[pos] != '{') {
+        return false;
+    }
+    pos = skip_whitespace(line, pos + 1);
+    if (pos < line.size() && line[pos] == '}') {
+        return skip_whitespace(line, pos + 1) == line.size();
+    }
+    for (;;) {
+        if (pos >= line.size() || line[pos] != '"') {
+            return false;
+        }
+        bool key_escaped = false;
+        size_t key_end = find_json_string_end(line, pos + 1, key_escaped);
+        if (key_end == std::string_view::npos) {
+            return false;
+        }
+        std::string_view key = line.substr(pos + 1, key_end - pos - 1);
+        pos = skip_whitespace(line, key_end + 1);
+        if (pos >= line.size() || line[pos] != ':') {
+            return false;
+        }
+        pos = skip_whitespace(line, pos + 1);
+        if (pos >= line.size()) {
+            return false;
+        }
+        if (line[pos] == '"') {
+            bool escaped = false;
+            size_t end = find_json_string_end(line, pos + 1, escaped);
+            if (end == std::string_view::npos) {
+                return false;
+            }
+            if (!on_field(key, key_escaped, Field{pos + 1, end, true, escaped, 0})) {
+                return false;
+            }
+            pos = end + 1;
+        } else {
+            pos = skip_json_value(line, pos);
+            if (pos == std::string_view::npos) {
+                return false;
+            }
+        }
+        pos = skip_whitespace(line, pos);
+        if (pos < line.size() && line[pos] == ',') {
+            pos = skip_whitespace(line, pos + 1);
+        } else if (pos < line.size() && line[pos] == '}') {
+            return skip_whitespace(line, pos + 1) == line.size();
+        } else {
+            return false;
+        }
+    }
+}
+
+// Calls on_field(field) for every field of a delimited record. With quoting (CSV), a field starting with a quote
+// runs to the matching quote, with "" standing for a quote inside it.
+template <typename OnField>
+bool split_delimited(std::string_view record, char delimiter, bool quoting, OnField&& on_field) {
+    size_t pos = 0;
+    for (size_t column = 0;; ++column) {
+        Field field{pos, pos, false, false, column};
+        if (quoting && pos < record.size() && record[pos] == '"') {
+            size_t close = pos + 1;
+            for (;;) {
+                close = record.find('"', close);
+                if (close == std::string_view::npos) {
+                    return false;
+                }
+                if (close + 1 < record.size() && record[close + 1] == '"') {
+                    field.escaped = true;
+                    close += 2;
+                    continue;
+                }
+                break;
+            }
+            field = Field{pos + 1, close, true, field.escaped, column};
+            pos = close + 1;
+            if (pos < record.size() && record[pos] != delimiter) {
+                return false;
+            }
+        } else {
+            pos = std::min(record.find(delimiter, pos), record.size());
+            field.end = pos;
+        }
+        if (!on_field(field)) {
+            return false;
+        }
+        if (pos >= record.size()) {
+            return true;
+        }
+        ++pos;
+    }
+}
+
+uint32_t parse_hex4(std::string_view s, size_t pos, bool& ok) {
+    uint32_t value = 0;
+    ok = pos + 4 <= s.size();
+    for (size_t i = pos; ok && i < pos + 4; ++i) {
+        char c = s[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= static_cast<uint32_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value |= static_cast<uint32_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            value |= static_cast<uint32_t>(c - 'A' + 10);
+        } else {
+            ok = false;
+        }
+    }
+    return value;
+}
+
+// Decodes the contents of a JSON string; unpaired surrogate escapes become U+FFFD
+bool decode_json_string(std::string_view raw, std::string& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t backslash = std::min(raw.find('\\', pos), raw.size());
+        out.append(raw.data() + pos, backslash - pos);
+        if (backslash == raw.size()) {
+            break;
+        }
+        if (backslash + 1 >= raw.size()) {
+            return false;
+        }
+        pos = backslash + 2;
+        switch (raw[backslash + 1]) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                bool ok = false;
+                char32_t cp = parse_hex4(raw, pos, ok);
+                if (!ok) {
+                    return false;
+                }
+                pos += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF && raw.substr(pos, 2) == "\\u") {
+                    char32_t low = parse_hex4(raw, pos + 2, ok);
+                    if (ok && low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        pos += 6;
+                    }
+                }
+                if (cp >= 0xD800 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                out += utf8_utils::codepoint_to_utf8(cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+void encode_json_string(std::string_view value, std::string& out) {
+    static const char HEX[] = "0123456789abcdef";
+    size_t pos = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(value.data() + pos, i - pos);
+        pos = i + 1;
+        out.push_back('\\');
+        switch (c) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '\b': out.push_back('b'); break;
+            case '\f': out.push_back('f'); break;
+            case '\n': out.push_back('n'); break;
+            case '\r': out.push_back('r'); break;
+            case '\t': out.push_back('t'); break;
+            default:
+                out += "u00";
+                out.push_back(HEX[c >> 4]);
+                out.push_back(HEX[c & 0xF]);
+                break;
+        }
+    }
+    out.append(value.data() + pos, value.size() - pos);
+}
+
+// CSV and TSV records may end in the CR of a CRLF line break, which is not part of the last field
+std::string_view strip_carriage_return(std::string_view record, RecordFormat format) {
+    if (format != RecordFormat::JSONL && !record.empty() && record.back() == '\r') {
+        record.remove_suffix(1);
+    }
+    return record;
+}
+
+} // namespace
+
+RecordFieldRewriter::RecordFieldRewriter(RecordFormat format, std::vector<std::string> fields)
+    : format_(format), fields_(std::move(fields)) {
+    std::sort(fields_.begin(), fields_.end());
+    fields_.erase(std::unique(fields_.begin(), fields_.end()), fields_.end());
+}
+
+bool RecordFieldRewriter::selected(std::string_view name) const {
+    return fields_.empty() || std::binary_search(fields_.begin(), fields_.end(), name);
+}
+
+bool RecordFieldRewriter::read_header(std::string_view record) {
+    record = strip_carriage_return(record, format_);
+    columns_.clear();
+    bool ok = split_delimited(record, format_ == RecordFormat::CSV ? ',' : '\t', format_ == RecordFormat::CSV,
+                              [&](const Field& field) {
+        std::string_view name;
+        if (!decode(record, field, name)) {
+            return false;
+        }
+        columns_.emplace_back(name);
+        return true;
+    });
+    selected_columns_.clear();
+    for (const auto& column : columns_) {
+        selected_columns_.push_back(selected(column));
+    }
+    header_read_ = ok;
+    return ok;
+}
+
+std::vector<std::string> RecordFieldRewriter::missing_fields() const {
+    std::vector<std::string> missing;
+    for (const auto& field : fields_) {
+        if (std::find(columns_.begin(), columns_.end(), field) == columns_.end()) {
+            missing.push_back(field);
+        }
+    }
+    return missing;
+}
+
+bool RecordFieldRewriter::record_complete(std::string_view text) const {
+    if (format_ != RecordFormat::CSV) {
+        return true;
+    }
+    // Same quoting rules as split_delimited: only a quote that starts a field opens a quoted section, and "" inside
+    // one is an escaped quote. A bare quote inside an unquoted field (5" screen) is plain text.
+    bool quoted = false;
+    bool field_start = true;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (quoted) {
+            if (c == '"') {
+                if (i + 1 < text.size() && text[i + 1] == '"') {
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            }
+        } else if (c == ',') {
+            field_start = true;
+        } else {
+            quoted = c == '"' && field_start;
+            field_start = false;
+        }
+    }
+    return !quoted;
+}
+
+template <typename OnField>
+bool RecordFieldRewriter::scan(std::string_view record, OnField&& on_field) {
+    if (format_ == RecordFormat::JSONL) {
+        return scan_json_object(record, [&](std::string_view key, bool key_escaped, const Field& field) {
+            if (!fields_.empty()) {
+                if (key_escaped) {
+                    if (!decode_json_string(key, key_)) {
+                        return false;
+                    }
+                    key = key_;
+                }
+                if (!selected(key)) {
+                    return true;
+                }
+            }
+            return on_field(field);
+        });
+    }
+    return split_delimited(record, format_ == RecordFormat::CSV ? ',' : '\t', format_ == RecordFormat::CSV,
+                           [&](const Field& field) {
+        bool wanted = fields_.empty() || (field.column < selected_columns_.size() && selected_columns_[field.column]);
+        return wanted ? on_field(field) : true;
+    });
+}
+
+bool RecordFieldRewriter::decode(std::string_view record, const Field& field, std::string_view& value) {
+    value = record.substr(field.begin, field.end - field.begin);
+    if (!field.escaped) {
+        return true;
+    }
+    if (format_ == RecordFormat::JSONL) {
+        if (!decode_json_string(value, scratch_)) {
+            return false;
+        }
+    } else {
+        scratch_.clear();
+        for (size_t i = 0; i < value.size(); ++i) {
+            scratch_.push_back(value[i]);
+            if (value[i] == '"') {
+                ++i;  // the second quote of ""
+            }
+        }
+    }
+    value = scratch_;
+    return true;
+}
+
+void RecordFieldRewriter::encode(std::string_view value, const Field& field, std::string& out) const {
+    switch (format_) {
+        case RecordFormat::JSONL:
+            encode_json_string(value, out);
+            break;
+        case RecordFormat::CSV: {
+            // A value that now holds a separator, quote or line break has to be quoted
+            bool quote = !field.quoted && value.find_first_of(",\"\r\n") != std::string_view::npos;
+            if (quote) {
+                out.push_back('"');
+            }
+            if (field.quoted || quote) {
+                for (char c : value) {
+                    out.push_back(c);
+                    if (c == '"') {
+                        out.push_back('"');
+                    }
+                }
+            } else {
+                out.append(value);
+            }
+            if (quote) {
+                out.push_back('"');
+            }
+            break;
+        }
+        case RecordFormat::TSV:
+            // TSV has no way to escape these; a space keeps the record intact
+            for (char c : value) {
+                out.push_back(c == '\t' || c == '\r' || c == '\n' ? ' ' : c);
+            }
+            break;
+    }
+}
+
+bool RecordFieldRewriter::visit(std::string_view record, const std::function<void(std::string_view value)>& visit) {
+    record = strip_carriage_return(record, format_);
+    return scan(record, [&](const Field& field) {
+        std::string_view value;
+        if (!decode(record, field, value)) {
+            return false;
+        }
+        visit(value);
+        return true;
+    });
+}
+
+bool RecordFieldRewriter::rewrite(std::string_view record, const Transform& transform, std::string& out) {
+    const size_t start = out.size();
+    std::string_view body = strip_carriage_return(record, format_);
+    size_t copied = 0;
+    bool ok = scan(body, [&](const Field& field) {
+        std::string_view value;
+        if (!decode(body, field, value)) {
+            return false;
+        }
+        transformed_.clear();
+        transform(value, transformed_);
+        if (transformed_ == value) {
+            return true;
+        }
+        out.append(body.data() + copied, field.begin - copied);
+        encode(transformed_, field, out);
+        copied = field.end;
+        return true;
+    });
+    if (!ok) {
+        out.resize(start);
+        out.append(record);
+        return false;
+    }
+    out.append(record.data() + copied, record.size() - copied);
+    return true;
+}
+
+} // namespace unicode_confusables
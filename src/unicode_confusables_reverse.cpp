@@ -0,0 +1,97 @@
+#include "unicode_confusables_reverse.h"
+#include "unicode_confusables_internal.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace unicode_confusables {
+
+namespace {
+
+// Canonical strings are sorted; row i owns sources [row_begin[i], row_begin[i + 1])
+struct ReverseTable {
+    std::string canonical_bytes;
+    std::vector<uint32_t> canonical_offsets;
+    std::vector<uint32_t> row_begin;
+    std::vector<char32_t> sources;
+
+    size_t canonical_count() const { return row_begin.empty() ? 0 : row_begin.size() - 1; }
+
+    std::string_view canonical(size_t index) const {
+        return std::string_view(canonical_bytes).substr(canonical_offsets[index],
+                                                        canonical_offsets[index + 1] - canonical_offsets[index]);
+    }
+};
+
+ReverseTable build_reverse_table(const detail::CanonicalTable& table) {
+    // (canonical, source) pairs; char_traits<char> compares bytes as unsigned, so UTF-8 order is codepoint order
+    std::vector<std::pair<std::string_view, char32_t>> pairs;
+    pairs.reserve(table.size());
+    size_t canonical_size = 0;
+    for (const auto& kv : table) {
+        // Keys of several codepoints are never looked up by normalize_confusables
+        size_t codepoints = 0;
+        char32_t source = 0;
+        detail::for_each_codepoint(kv.first, [&](char32_t cp, size_t, size_t) {
+            source = cp;
+            ++codepoints;
+        });
+        if (codepoints != 1) {
+            continue;
+        }
+        pairs.emplace_back(kv.second, source);
+        canonical_size += kv.second.size();
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    ReverseTable reverse;
+    reverse.canonical_bytes.reserve(canonical_size);
+    reverse.sources.reserve(pairs.size());
+    reverse.canonical_offsets.push_back(0);
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (i == 0 || pairs[i].first != pairs[i - 1].first) {
+            reverse.canonical_bytes += pairs[i].first;
+            reverse.canonical_offsets.push_back(static_cast<uint32_t>(reverse.canonical_bytes.size()));
+            reverse.row_begin.push_back(static_cast<uint32_t>(i));
+        }
+        reverse.sources.push_back(pairs[i].second);
+    }
+    reverse.row_begin.push_back(static_cast<uint32_t>(pairs.size()));
+    reverse.canonical_bytes.shrink_to_fit();
+    reverse.canonical_offsets.shrink_to_fit();
+    reverse.row_begin.shrink_to_fit();
+    return reverse;
+}
+
+const ReverseTable& reverse_table(bool fold_case) {
+    static std::once_flag built[2];
+    static ReverseTable tables[2];
+    size_t mode = fold_case ? 1 : 0;
+    std::call_once(built[mode], [&]() { tables[mode] = build_reverse_table(detail::canonical_table(fold_case)); });
+    return tables[mode];
+}
+
+} // namespace
+
+ConfusableList confusables_of(std::string_view canonical, bool fold_case) {
+    const ReverseTable& table = reverse_table(fold_case);
+    size_t low = 0;
+    size_t high = table.canonical_count();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (table.canonical(mid) < canonical) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == table.canonical_count() || table.canonical(low) != canonical) {
+        return ConfusableList();
+    }
+    uint32_t first = table.row_begin[low];
+    return ConfusableList(table.sources.data() + first, table.row_begin[low + 1] - first);
+}
+
+} // namespace unicode_confusables
@@ -0,0 +1,80 @@
+#include "unicode_confusables_scripts.h"
+#include "unicode_confusables_internal.h"
+#include <unicode/uchar.h>
+
+namespace unicode_confusables {
+
+static_assert(ScriptSet::WORDS == SCRIPT_SET_WORDS, "ScriptSet::WORDS must match the generated script set table");
+
+namespace {
+
+const uint64_t* script_set_words(char32_t cp) {
+    size_t block = SCRIPT_SET_BLOCKS[cp >> SCRIPT_SET_SHIFT];
+    return SCRIPT_SETS[SCRIPT_SET_INDEX[(block << SCRIPT_SET_SHIFT) | (cp & SCRIPT_SET_MASK)]];
+}
+
+} // namespace
+
+ScriptSet ScriptSet::all() {
+    const uint64_t words[WORDS] = {~uint64_t(0), ~uint64_t(0), ~uint64_t(0), ~uint64_t(0)};
+    return ScriptSet(words);
+}
+
+bool ScriptSet::is_all() const {
+    return *this == all();
+}
+
+std::vector<UScriptCode> ScriptSet::scripts() const {
+    std::vector<UScriptCode> result;
+    const int32_t max_script = u_getIntPropertyMaxValue(UCHAR_SCRIPT);
+    for (int32_t script = 0; script <= max_script && static_cast<size_t>(script) < WORDS * 64; ++script) {
+        if (contains(static_cast<UScriptCode>(script))) {
+            result.push_back(static_cast<UScriptCode>(script));
+        }
+    }
+    return result;
+}
+
+ScriptSet script_set_of(char32_t cp) {
+    return ScriptSet(script_set_words(cp > 0x10FFFF ? char32_t(0xFFFD) : cp));
+}
+
+Analysis analyze(std::string_view input) {
+    Analysis result;
+    // Resolved set of the codepoints outside Latin (Common and Inherited count as Latin here), which tells
+    // the Latin-plus-one-script levels apart
+    ScriptSet without_latin = ScriptSet::all();
+    bool ascii = true;
+    std::string utf8_char;
+    detail::for_each_codepoint(input, [&](char32_t cp, size_t, size_t) {
+        // CONFUSABLE_TO_CANONICAL has no ASCII sources
+        if (cp >= 0x80) {
+            ascii = false;
+            if (detail::find_canonical(CONFUSABLE_TO_CANONICAL, cp, utf8_char)) {
+                result.confusables.insert(utf8_char);
+            }
+        }
+        const ScriptSet scripts(script_set_words(cp));
+        result.resolved_scripts &= scripts;
+        if (!scripts.contains(USCRIPT_LATIN)) {
+            without_latin &= scripts;
+        }
+    });
+
+    if (ascii) {
+        result.restriction_level = RestrictionLevel::ASCII_ONLY;
+    } else if (!result.resolved_scripts.empty()) {
+        result.restriction_level = RestrictionLevel::SINGLE_SCRIPT;
+    } else if (without_latin.contains(USCRIPT_HAN_WITH_BOPOMOFO) || without_latin.contains(USCRIPT_JAPANESE) ||
+               without_latin.contains(USCRIPT_KOREAN)) {
+        result.restriction_level = RestrictionLevel::HIGHLY_RESTRICTIVE;
+    } else if (!without_latin.empty() && !without_latin.contains(USCRIPT_CYRILLIC) &&
+               !without_latin.contains(USCRIPT_GREEK) && !without_latin.contains(USCRIPT_CHEROKEE)) {
+        result.restriction_level = RestrictionLevel::MODERATELY_RESTRICTIVE;
+    } else {
+        result.restriction_level = RestrictionLevel::MINIMALLY_RESTRICTIVE;
+    }
+    return result;
+}
+
+} // namespace unicode_confusables
@@ -0,0 +1,520 @@
+#include "unicode_confusables_server.h"
+#include "unicode_confusables.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace unicode_confusables {
+
+struct NormalizationServer::Connection {
+    int fd = -1;
+    std::string input;   // received bytes not yet handed to a worker
+    std::string output;  // responses in order; output[output_sent, size) is still to be written
+    size_t output_sent = 0;
+    uint64_t next_sequence = 0;  // of the next batch handed to the workers
+    uint64_t next_delivery = 0;  // batch whose responses are written next
+    std::map<uint64_t, std::string> early;  // responses of batches that finished ahead of next_delivery
+    size_t early_bytes = 0;
+    size_t in_flight_bytes = 0;  // request bytes at the workers, a stand-in for the responses to come
+    bool read_closed = false;    // the peer is done sending, or sent an oversized frame
+    bool failed = false;
+    uint32_t events = 0;  // registered with epoll
+
+    // Completed responses count with their real size
+    size_t pending_output() const { return output.size() - output_sent + early_bytes + in_flight_bytes; }
+    bool busy() const { return next_delivery != next_sequence || output_sent < output.size(); }
+};
+
+namespace {
+
+std::string system_error(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+bool fill_address(const std::string& path, sockaddr_un& address) {
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.data(), path.size());
+    return true;
+}
+
+// Appends the response frame for one request
+void answer_request(const protocol::FrameHeader& header, std::string_view payload, std::string& out) {
+    using protocol::Operation;
+    using protocol::Status;
+    Status status = Status::OK;
+    std::string result;
+    std::string_view reply;
+    switch (static_cast<Operation>(header.code)) {
+        case Operation::PING:
+            reply = payload;
+            break;
+        case Operation::NORMALIZE_CONFUSABLES: {
+            const unsigned normalization = (header.flags & protocol::NORMALIZATION_MASK) >> protocol::NORMALIZATION_SHIFT;
+            if ((header.flags & ~(protocol::FLAG_FOLD_CASE | protocol::NORMALIZATION_MASK)) != 0 || normalization > 4) {
+                status = Status::BAD_REQUEST;
+                break;
+            }
+            const bool fold_case = (header.flags & protocol::FLAG_FOLD_CASE) != 0;
+            if (normalization == 0) {
+                result = normalize_confusables(payload, fold_case);
+            } else {
+                static const NormalizationType TYPES[] = {NormalizationType::NFC, NormalizationType::NFD,
+                                                          NormalizationType::NFKC, NormalizationType::NFKD};
+                result = normalize_confusables(unicode_normalize(payload, TYPES[normalization - 1], true), fold_case);
+            }
+            reply = result;
+            break;
+        }
+        case Operation::CONTAINS_CONFUSABLES: {
+            if (header.flags != 0) {
+                status = Status::BAD_REQUEST;
+                break;
+            }
+            auto found = contains_confusables(payload);
+            // UTF-8 byte order is codepoint order
+            std::vector<std::string> sorted(found.begin(), found.end());
+            std::sort(sorted.begin(), sorted.end());
+            for (const auto& confusable : sorted) {
+                result += confusable;
+            }
+            reply = result;
+            break;
+        }
+        default:
+            status = Status::BAD_REQUEST;
+            break;
+    }
+    protocol::append_frame(out, header.id, static_cast<uint8_t>(status), 0, reply);
+}
+
+// Same, but a failure (bad_alloc on a huge payload, an exception from ICU) only fails this request instead of
+// escaping the worker thread and terminating the server
+void handle_request(const protocol::FrameHeader& header, std::string_view payload, std::string& out) {
+    const size_t mark = out.size();
+    try {
+        answer_request(header, payload, out);
+    } catch (...) {
+        out.resize(mark);
+        protocol::append_frame(out, header.id, static_cast<uint8_t>(protocol::Status::INTERNAL_ERROR), 0,
+                               std::string_view());
+    }
+}
+
+} // namespace
+
+NormalizationServer::NormalizationServer(const ServerOptions& options) : options_(options) {
+    if (options_.max_batch == 0) {
+        options_.max_batch = 1;
+    }
+}
+
+NormalizationServer::~NormalizationServer() {
+    shutdown();
+    if (epoll_fd_ >= 0) {
+        ::close(epoll_fd_);
+    }
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+    }
+}
+
+bool NormalizationServer::listen(const std::string& socket_path) {
+    sockaddr_un address;
+    if (!fill_address(socket_path, address)) {
+        error_ = "invalid socket path '" + socket_path + "'";
+        return false;
+    }
+    // A socket file left by a server that is gone is replaced; a live one is not
+    struct stat status;
+    if (lstat(socket_path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            error_ = socket_path + " exists and is not a socket";
+            return false;
+        }
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (live) {
+            error_ = "another server is listening on " + socket_path;
+            return false;
+        }
+        ::unlink(socket_path.c_str());
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        error_ = system_error("socket");
+        return false;
+    }
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        error_ = system_error("bind " + socket_path);
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    socket_path_ = socket_path;
+    // Nobody can connect before listen(), so the umask's permissions are never usable
+    if (::chmod(socket_path.c_str(), static_cast<mode_t>(options_.socket_mode & 07777)) != 0) {
+        error_ = system_error("chmod " + socket_path);
+        shutdown();
+        return false;
+    }
+    if (::listen(listen_fd_, SOMAXCONN) != 0) {
+        error_ = system_error("listen");
+        shutdown();
+        return false;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        error_ = system_error("epoll/eventfd");
+        shutdown();
+        return false;
+    }
+    epoll_event listen_event{};
+    listen_event.events = EPOLLIN;
+    listen_event.data.u64 = 0;
+    epoll_event wake_event{};
+    wake_event.events = EPOLLIN;
+    wake_event.data.u64 = 1;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &listen_event) != 0 ||
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &wake_event) != 0) {
+        error_ = system_error("epoll_ctl");
+        shutdown();
+        return false;
+    }
+    return true;
+}
+
+void NormalizationServer::stop() {
+    stopping_ = true;
+    if (wake_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+bool NormalizationServer::run() {
+    if (listen_fd_ < 0 || epoll_fd_ < 0) {
+        error_ = "the server is not listening";
+        return false;
+    }
+    size_t thread_count = options_.worker_threads;
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_stopping_ = false;
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&NormalizationServer::worker_loop, this);
+    }
+
+    bool ok = true;
+    epoll_event events[64];
+    while (!stopping_) {
+        int count = epoll_wait(epoll_fd_, events, 64, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_ = system_error("epoll_wait");
+            ok = false;
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            const uint64_t id = events[i].data.u64;
+            if (id == 0) {
+                accept_connections();
+                continue;
+            }
+            if (id == 1) {
+                uint64_t wakeups;
+                ssize_t ignored = ::read(wake_fd_, &wakeups, sizeof(wakeups));
+                (void)ignored;
+                collect_completed();
+                continue;
+            }
+            auto it = connections_.find(id);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& connection = *it->second;
+            // EPOLLHUP on a Unix socket: the peer closed both directions, nobody is left to answer
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_connection(id);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                read_connection(id, connection);
+            }
+            if (events[i].events & EPOLLOUT) {
+                write_connection(connection);
+            }
+            if (!close_if_done(id, connection)) {
+                update_events(id, connection);
+            }
+        }
+    }
+    shutdown();
+    return ok;
+}
+
+void NormalizationServer::worker_loop() {
+    for (;;) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_ready_.wait(lock, [this] { return workers_stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            batch = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        // Frames were checked to be complete when the batch was cut
+        size_t pos = 0;
+        while (pos + protocol::HEADER_SIZE <= batch.requests.size()) {
+            protocol::FrameHeader header = protocol::read_header(batch.requests.data() + pos);
+            std::string_view payload(batch.requests.data() + pos + protocol::HEADER_SIZE, header.payload_length);
+            handle_request(header, payload, batch.responses);
+            pos += protocol::HEADER_SIZE + header.payload_length;
+        }
+        {
+            std::lock_guard<std::mutex> lock(completed_mutex_);
+            completed_.push_back(std::move(batch));
+        }
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void NormalizationServer::accept_connections() {
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // EAGAIN, or out of descriptors until connections close
+        }
+        const uint64_t id = next_connection_++;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        connections_.emplace(id, std::move(connection));
+    }
+}
+
+void NormalizationServer::read_connection(uint64_t id, Connection& connection) {
+    char buffer[1 << 16];
+    while (!connection.read_closed && connection.pending_output() <= options_.max_pending_output) {
+        ssize_t n = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            connection.input.append(buffer, static_cast<size_t>(n));
+            if (static_cast<size_t>(n) < sizeof(buffer)) {
+                break;
+            }
+        } else if (n == 0) {
+            connection.read_closed = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                connection.failed = true;
+            }
+            break;
+        }
+    }
+
+    // Cut the complete frames into batches of at most max_batch requests
+    std::vector<Batch> batches;
+    size_t batch_begin = 0;
+    size_t pos = 0;
+    size_t frames = 0;
+    auto cut = [&](size_t end) {
+        if (end > batch_begin) {
+            batches.push_back(Batch{id, connection.next_sequence++, connection.input.substr(batch_begin, end - batch_begin), std::string()});
+            connection.in_flight_bytes += end - batch_begin;
+        }
+        batch_begin = end;
+        frames = 0;
+    };
+    while (connection.input.size() - pos >= protocol::HEADER_SIZE) {
+        protocol::FrameHeader header = protocol::read_header(connection.input.data() + pos);
+        if (header.payload_length > protocol::MAX_PAYLOAD) {
+            // The stream cannot be resynchronized: answer in order, then stop reading
+            cut(pos);
+            std::string reply;
+            protocol::append_frame(reply, header.id, static_cast<uint8_t>(protocol::Status::TOO_LARGE), 0, std::string_view());
+            deliver(connection, connection.next_sequence++, std::move(reply));
+            connection.read_closed = true;
+            pos = batch_begin = connection.input.size();
+            break;
+        }
+        if (connection.input.size() - pos < protocol::HEADER_SIZE + header.payload_length) {
+            break;
+        }
+        pos += protocol::HEADER_SIZE + header.payload_length;
+        if (++frames == options_.max_batch) {
+            cut(pos);
+        }
+    }
+    cut(pos);
+    connection.input.erase(0, batch_begin);
+
+    if (!batches.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            for (auto& batch : batches) {
+                queue_.push_back(std::move(batch));
+            }
+        }
+        if (batches.size() == 1) {
+            queue_ready_.notify_one();
+        } else {
+            queue_ready_.notify_all();
+        }
+    }
+}
+
+void NormalizationServer::write_connection(Connection& connection) {
+    while (connection.output_sent < connection.output.size()) {
+        ssize_t n = ::send(connection.fd, connection.output.data() + connection.output_sent,
+                           connection.output.size() - connection.output_sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.output_sent += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                connection.failed = true;
+            }
+            break;
+        }
+    }
+    if (connection.output_sent == connection.output.size()) {
+        connection.output.clear();
+        connection.output_sent = 0;
+    }
+}
+
+void NormalizationServer::deliver(Connection& connection, uint64_t sequence, std::string&& responses) {
+    if (sequence != connection.next_delivery) {
+        connection.early_bytes += responses.size();
+        connection.early.emplace(sequence, std::move(responses));
+        return;
+    }
+    connection.output += responses;
+    ++connection.next_delivery;
+    for (auto it = connection.early.begin(); it != connection.early.end() && it->first == connection.next_delivery;
+         it = connection.early.erase(it)) {
+        connection.output += it->second;
+        connection.early_bytes -= it->second.size();
+        ++connection.next_delivery;
+    }
+}
+
+void NormalizationServer::collect_completed() {
+    std::vector<Batch> completed;
+    {
+        std::lock_guard<std::mutex> lock(completed_mutex_);
+        completed.swap(completed_);
+    }
+    for (auto& batch : completed) {
+        auto it = connections_.find(batch.connection);
+        if (it == connections_.end()) {
+            continue;  // closed meanwhile
+        }
+        Connection& connection = *it->second;
+        connection.in_flight_bytes -= batch.requests.size();
+        deliver(connection, batch.sequence, std::move(batch.responses));
+        write_connection(connection);
+        if (!close_if_done(batch.connection, connection)) {
+            update_events(batch.connection, connection);
+        }
+    }
+}
+
+bool NormalizationServer::close_if_done(uint64_t id, Connection& connection) {
+    if (connection.failed || (connection.read_closed && !connection.busy())) {
+        close_connection(id);
+        return true;
+    }
+    return false;
+}
+
+void NormalizationServer::close_connection(uint64_t id) {
+    auto it = connections_.find(id);
+    if (it == connections_.end()) {
+        return;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second->fd, nullptr);
+    ::close(it->second->fd);
+    connections_.erase(it);
+}
+
+void NormalizationServer::update_events(uint64_t id, Connection& connection) {
+    uint32_t events = 0;
+    if (!connection.read_closed && connection.pending_output() <= options_.max_pending_output) {
+        events |= EPOLLIN;
+    }
+    if (connection.output_sent < connection.output.size()) {
+        events |= EPOLLOUT;
+    }
+    if (events != connection.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = events;
+    }
+}
+
+void NormalizationServer::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        workers_stopping_ = true;
+        queue_.clear();
+    }
+    queue_ready_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    completed_.clear();
+    while (!connections_.empty()) {
+        close_connection(connections_.begin()->first);
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    if (!socket_path_.empty()) {
+        ::unlink(socket_path_.c_str());
+        socket_path_.clear();
+    }
+}
+
+} // namespace unicode_confusables
@@ -0,0 +1,127 @@
+#include "unicode_confusables_variants.h"
+#include "unicode_confusables.h"
+#include "unicode_confusables_internal.h"
+#include "unicode_confusables_reverse.h"
+#include <algorithm>
+
+namespace unicode_confusables {
+
+namespace {
+
+constexpr uint64_t SATURATED = std::numeric_limits<uint64_t>::max();
+
+uint64_t saturating_add(uint64_t a, uint64_t b) {
+    return a > SATURATED - b ? SATURATED : a + b;
+}
+
+uint64_t saturating_mul(uint64_t a, uint64_t b) {
+    return b != 0 && a > SATURATED / b ? SATURATED : a * b;
+}
+
+bool script_allowed(char32_t source, const std::vector<UScriptCode>& allowed_scripts) {
+    if (allowed_scripts.empty()) {
+        return true;
+    }
+    return std::any_of(allowed_scripts.begin(), allowed_scripts.end(), [source](UScriptCode script) {
+        return uscript_hasScript(static_cast<UChar32>(source), script);
+    });
+}
+
+} // namespace
+
+VariantGenerator::VariantGenerator(std::string_view term, const VariantOptions& options)
+    : canonical_(normalize_confusables(term, options.fold_case)) {
+    std::vector<char32_t> codepoints;
+    detail::for_each_codepoint(canonical_, [&](char32_t cp, size_t begin, size_t) {
+        codepoints.push_back(cp);
+        offsets_.push_back(begin);
+    });
+    offsets_.push_back(canonical_.size());
+
+    // Runs of any length can have look-alikes. Normalization is not idempotent everywhere (U+01C6 gives "d\u017E",
+    // whose U+017E gives 'z'), so a canonical codepoint can only be kept if it normalizes to itself; such a
+    // codepoint is never a source, so keeps and look-alikes cannot spell the same variant twice.
+    const detail::CanonicalTable& table = detail::canonical_table(options.fold_case);
+    const size_t length = codepoints.size();
+    std::string utf8_char;
+    for (size_t start = 0; start < length; ++start) {
+        keepable_.push_back(detail::find_canonical(table, codepoints[start], utf8_char) == nullptr);
+        run_begin_.push_back(runs_.size());
+        for (size_t end = start + 1; end <= length; ++end) {
+            std::string_view run = std::string_view(canonical_).substr(offsets_[start], offsets_[end] - offsets_[start]);
+            size_t option_begin = options_.size();
+            for (char32_t source : confusables_of(run, options.fold_case)) {
+                if (script_allowed(source, options.allowed_scripts)) {
+                    options_.push_back(utf8_utils::codepoint_to_utf8(source));
+                }
+            }
+            if (options_.size() > option_begin) {
+                runs_.push_back(Run{end, option_begin, options_.size()});
+            }
+        }
+    }
+    run_begin_.push_back(runs_.size());
+
+    // completions(p, r) = (keep p ? completions(p + 1, r) : 0) + sum over runs [p, e) of (look-alikes) * completions(e, r - 1)
+    max_substitutions_ = std::min(options.max_substitutions, length);
+    size_t stride = max_substitutions_ + 1;
+    completions_.assign((length + 1) * stride, 1);
+    for (size_t position = length; position-- > 0; ) {
+        for (size_t r = 0; r <= max_substitutions_; ++r) {
+            uint64_t total = keepable_[position] ? completions(position + 1, r) : 0;
+            if (r > 0) {
+                for (size_t i = run_begin_[position]; i < run_begin_[position + 1]; ++i) {
+                    const Run& run = runs_[i];
+                    total = saturating_add(total, saturating_mul(run.option_end - run.option_begin, completions(run.end, r - 1)));
+                }
+            }
+            completions_[position * stride + r] = total;
+        }
+    }
+    count_ = std::min(completions(0, max_substitutions_), options.max_count);
+}
+
+void VariantGenerator::variant_at(uint64_t index, std::string& out) const {
+    out.clear();
+    size_t remaining = max_substitutions_;
+    const size_t length = offsets_.size() - 1;
+    for (size_t position = 0; position < length; ) {
+        // Keeping the canonical codepoint comes first, then the runs starting here, each look-alike in table order
+        uint64_t keep = keepable_[position] ? completions(position + 1, remaining) : 0;
+        const Run* chosen = nullptr;
+        if (index >= keep && remaining > 0) {
+            index -= keep;
+            for (size_t i = run_begin_[position]; i < run_begin_[position + 1]; ++i) {
+                const Run& run = runs_[i];
+                uint64_t per_option = completions(run.end, remaining - 1);
+                uint64_t options = run.option_end - run.option_begin;
+                uint64_t block = saturating_mul(options, per_option);
+                if (index < block) {
+                    uint64_t option = std::min<uint64_t>(index / per_option, options - 1);
+                    index -= option * per_option;
+                    out += options_[run.option_begin + option];
+                    chosen = &run;
+                    break;
+                }
+                index -= block;
+            }
+        }
+        if (chosen) {
+            position = chosen->end;
+            --remaining;
+        } else {
+            out.append(canonical_, offsets_[position], offsets_[position + 1] - offsets_[position]);
+            ++position;
+        }
+    }
+}
+
+bool VariantGenerator::next(std::string& out) {
+    if (position_ >= count_) {
+        return false;
+    }
+    variant_at(position_++, out);
+    return true;
+}
+
+} // namespace unicode_confusables
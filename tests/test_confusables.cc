@@ -1,8 +1,32 @@
 #include "unicode_confusables.h"
+#include "unicode_confusables_blocklist.h"
+#include "unicode_confusables_cache.h"
+#include "unicode_confusables_constexpr.h"
+#include "unicode_confusables_data.h"
+#include "unicode_confusables_distance.h"
+#include "unicode_confusables_incremental.h"
+#include "unicode_confusables_offsets.h"
+#include "unicode_confusables_records.h"
+#include "unicode_confusables_reverse.h"
+#include "unicode_confusables_scripts.h"
+#include "unicode_confusables_variants.h"
 #include "utf8_utils.h"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
+#include <random>
 #include <string>
+#include <thread>
+#include <unicode/uspoof.h>
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+#include "unicode_confusables_client.h"
+#include "unicode_confusables_server.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 using namespace unicode_confusables;
 
@@ -48,6 +72,749 @@ void test_ascii_negative() {
     assert(actual1 == "hello");
 }
 
+void test_fold_case_confusable() {
+    // Greek capital Rho + Cyrillic capital A + 'Y' + Cyrillic small a + "L", visually "PAYaL"
+    std::string input = "\xCE\xA1\xD0\x90Y\xD0\xB0L";
+    std::string expected = "payal";
+    std::string actual = normalize_confusables(input, true);
+    if (actual != expected) {
+        std::cout << "[FAIL] test_fold_case_confusable:\n  got:      '" << actual << "'\n  expected: '" << expected << "'\n";
+        std::cout.flush();
+        return;
+    }
+    assert(actual == expected);
+    // Without folding, case is preserved
+    assert(normalize_confusables(input) == "PAYaL");
+    // Plain ASCII is folded too
+    assert(normalize_confusables("Hello World", true) == "hello world");
+}
+
+void test_normalize_into_buffer() {
+    std::string input = "p\xD0\xB0yp\xD0\xB0l \xF0\x9D\x91\x90"; // Cyrillic 'а' twice + mathematical italic 'c'
+    std::string expected = normalize_confusables(input);
+    std::string buffer(normalize_confusables_max_size(input.size()), '\0');
+    size_t written = normalize_confusables_into(input, &buffer[0], buffer.size());
+    if (written != expected.size() || buffer.compare(0, written, expected) != 0) {
+        std::cout << "[FAIL] test_normalize_into_buffer:\n  got:      '" << buffer.substr(0, written) << "'\n  expected: '" << expected << "'\n";
+        std::cout.flush();
+        return;
+    }
+    // Too small a buffer reports the required size
+    char small[2];
+    assert(normalize_confusables_into(input, small, sizeof(small)) == expected.size());
+    // Worst case: every ill-formed byte becomes U+FFFD
+    assert(normalize_confusables_max_size(1) >= 3);
+}
+
+void test_normalize_inplace() {
+    // Every replacement shrinks or keeps the length: normalized entirely in place
+    std::string shrinking = "p\xD0\xB0yp\xD0\xB0l \xF0\x9D\x91\x90"; // Cyrillic 'а' twice + mathematical italic 'c'
+    std::string expected = normalize_confusables(shrinking);
+    size_t len = shrinking.size();
+    size_t resume = 0;
+    bool complete = normalize_confusables_inplace(&shrinking[0], len, resume);
+    shrinking.resize(len);
+    if (!complete || shrinking != expected) {
+        std::cout << "[FAIL] test_normalize_inplace:\n  got:      '" << shrinking << "'\n  expected: '" << expected << "'\n";
+        std::cout.flush();
+        return;
+    }
+    assert(resume == len);
+
+    // An ill-formed byte becomes the longer U+FFFD, so the rest is handed to the out-of-place path
+    std::string growing = "\xD0\xB0" "b\xFF" "\xD0\xB0";
+    expected = normalize_confusables(growing);
+    len = growing.size();
+    complete = normalize_confusables_inplace(&growing[0], len, resume);
+    assert(!complete);
+    assert(growing.compare(0, resume, "ab") == 0);
+    std::string finished = growing.substr(0, resume) + normalize_confusables(std::string_view(growing.data() + resume, len - resume));
+    assert(finished == expected);
+}
+
+void test_cached_results() {
+    std::string token = "W\xCE\xBFrld"; // Greek omicron
+    CacheStats before = cache_stats();
+    std::string first = cached_normalize_confusables(token);
+    std::string second = cached_normalize_confusables(token);
+    if (first != normalize_confusables(token) || second != first) {
+        std::cout << "[FAIL] test_cached_results:\n  got:      '" << second << "'\n  expected: '" << normalize_confusables(token) << "'\n";
+        std::cout.flush();
+        return;
+    }
+    assert(cached_normalize_confusables(token, true) == normalize_confusables(token, true));
+    assert(cached_contains_confusables(token) == contains_confusables(token));
+    assert(cached_contains_confusables(token) == contains_confusables(token));
+
+    // Another thread misses its own tier but finds the entry in the shared tier
+    std::thread([&] { assert(cached_normalize_confusables(token) == first); }).join();
+
+    // Long inputs are not cached
+    std::string long_input(CACHE_MAX_INPUT_SIZE + 1, 'a');
+    assert(cached_normalize_confusables(long_input) == long_input);
+
+    CacheStats after = cache_stats();
+    assert(after.misses - before.misses == 3);
+    assert(after.thread_hits - before.thread_hits == 2);
+    assert(after.shared_hits - before.shared_hits == 1);
+    assert(after.bypassed - before.bypassed == 1);
+}
+
+void test_blocklist_matcher() {
+    BlocklistMatcher matcher({"paypal", "scam", "pal"});
+    // "Pay" + Cyrillic 'р' 'а' + "l scam" with a mathematical bold 's' (4 bytes)
+    std::string text = "pay\xD1\x80\xD0\xB0l \xF0\x9D\x90\xAC" "cam";
+    std::vector<BlocklistMatch> matches = matcher.find_all(text);
+    if (matches.size() != 3) {
+        std::cout << "[FAIL] test_blocklist_matcher:\n  got:      " << matches.size() << " matches\n  expected: 3\n";
+        std::cout.flush();
+        return;
+    }
+    // "paypal" and "pal" both end at the 'l', spans are in original byte offsets
+    assert(matches[0].pattern == 0 && matches[0].begin == 0 && matches[0].end == 8);
+    assert(matches[1].pattern == 2 && matches[1].begin == 3 && matches[1].end == 8);
+    assert(matches[2].pattern == 1 && matches[2].begin == 9 && matches[2].end == text.size());
+    assert(matcher.contains_any(text));
+    assert(!matcher.contains_any("nothing to see here"));
+
+    BlocklistMatcher folded({"PayPal"}, true);
+    assert(folded.contains_any("PAY\xD0\xA0" "AL"));  // Cyrillic capital 'Р'
+    assert(!BlocklistMatcher({"PayPal"}).contains_any("paypal"));
+}
+
+void test_offset_map() {
+    OffsetMap offsets;
+    // 'p' + two Cyrillic 'а' (2 bytes -> 1 each) + 'x'
+    std::string result = normalize_confusables("p\xD0\xB0\xD0\xB0x", false, offsets);
+    if (result != "paax") {
+        std::cout << "[FAIL] test_offset_map:\n  got:      '" << result << "'\n  expected: 'paax'\n";
+        std::cout.flush();
+        return;
+    }
+    assert(offsets.run_count() == 3);  // the two equal replacements share a run
+    assert(offsets.to_input(2) == 3 && offsets.to_input(3) == 5);
+    assert(offsets.to_output(2) == 1 && offsets.to_output(3) == 2);  // inside a replaced character
+    assert(offsets.to_input_span(1, 3) == (std::pair<size_t, size_t>(1, 5)));
+
+    // 'a' + ligature 'ﬁ' (U+FB01) + zero width space + 'b' -> "afib"
+    std::string input = "a\xEF\xAC\x81\xE2\x80\x8B" "b";
+    result = unicode_normalize(input, NormalizationType::NFKC, true, offsets);
+    assert(result == "afib" && result == unicode_normalize(input, NormalizationType::NFKC, true));
+    assert(offsets.input_size() == input.size() && offsets.output_size() == result.size());
+    assert(offsets.to_input(2) == 1 && offsets.to_input(3) == 7);
+    assert(offsets.to_input_span(2, 3) == (std::pair<size_t, size_t>(1, 4)));
+    assert(offsets.to_output(4) == 3);  // the stripped character
+
+    // Splicing keeps stripped characters outside the edit and shifts the runs after it
+    OffsetMap edit;
+    unicode_normalize("\xEF\xAC\x81" "c", NormalizationType::NFKC, true, edit);  // "fic"
+    offsets.splice(1, 4, edit);  // "a" + "ﬁc" + zero width space + "b"
+    OffsetMap expected_offsets;
+    std::string edited = "a\xEF\xAC\x81" "c\xE2\x80\x8B" "b";
+    assert(unicode_normalize(edited, NormalizationType::NFKC, true, expected_offsets) == "aficb");
+    assert(offsets.input_size() == edited.size() && offsets.output_size() == 5);
+    assert(offsets.run_count() == expected_offsets.run_count());
+    for (size_t i = 0; i <= edited.size(); ++i) {
+        assert(offsets.to_output(i) == expected_offsets.to_output(i));
+    }
+    for (size_t i = 0; i <= 5; ++i) {
+        assert(offsets.to_input(i) == expected_offsets.to_input(i));
+    }
+
+    // Ill-formed bytes become U+FFFD, as without an offset map
+    result = unicode_normalize("a\xFF" "b", NormalizationType::NFC, false, offsets);
+    assert(result == "a\xEF\xBF\xBD" "b" && result == unicode_normalize("a\xFF" "b", NormalizationType::NFC, false));
+    assert(offsets.to_input(4) == 2 && offsets.to_output_span(1, 2) == (std::pair<size_t, size_t>(1, 4)));
+}
+
+void test_incremental_normalizer() {
+    // Edits that split, join and break multi-byte sequences; the output must always match a full pass
+    const char* pieces[] = {"\xD0\xB0", "x", "\xF0\x9D\x90", "\xAC", "\xE2", "\x82\xAC", "\xC7\x86", "", "P\xD0\xA0"};
+    IncrementalNormalizer normalizer("pay\xD1\x80\xD0\xB0l", true);
+    unsigned seed = 12345;
+    for (int step = 0; step < 500; ++step) {
+        seed = seed * 1103515245u + 12345u;
+        size_t size = normalizer.input().size();
+        size_t begin = (seed >> 8) % (size + 1);
+        size_t end = begin + (seed >> 4) % 3;
+        NormalizationPatch patch = normalizer.replace(begin, end, pieces[(seed >> 16) % 9]);
+        std::string expected = normalize_confusables(normalizer.input(), true);
+        if (normalizer.output() != expected) {
+            std::cout << "[FAIL] test_incremental_normalizer at step " << step << ":\n  got:      '"
+                      << normalizer.output() << "'\n  expected: '" << expected << "'\n";
+            std::cout.flush();
+            return;
+        }
+        assert(patch.begin + patch.inserted <= expected.size());
+        OffsetMap fresh;
+        normalize_confusables(normalizer.input(), true, fresh);
+        for (size_t i = 0; i <= normalizer.input().size(); ++i) {
+            assert(normalizer.offsets().to_output(i) == fresh.to_output(i));
+        }
+        assert(normalizer.offsets().output_size() == expected.size());
+        assert(normalizer.offsets().run_count() == fresh.run_count());  // spliced runs merge like a full pass
+    }
+}
+
+void test_utf16_utf32_variants() {
+    auto to_utf8 = [](std::u16string_view text) {
+        std::string utf8;
+        icu::UnicodeString(text.data(), static_cast<int32_t>(text.size())).toUTF8String(utf8);
+        return utf8;
+    };
+    // Cyrillic 'а', mathematical bold 's' (surrogate pair), an unpaired surrogate
+    std::u16string input = u"p\u0430y \U0001D42Cam \xD800!";
+    std::u16string normalized = normalize_confusables(input, false);
+    std::string expected = normalize_confusables(to_utf8(input));
+    if (to_utf8(normalized) != expected) {
+        std::cout << "[FAIL] test_utf16_utf32_variants:\n  got:      '" << to_utf8(normalized) << "'\n  expected: '" << expected << "'\n";
+        std::cout.flush();
+        return;
+    }
+    assert(to_utf8(normalize_confusables(input, true)) == normalize_confusables(to_utf8(input), true));
+    assert(normalize_confusables(U"p\u0430y \U0001D42Cam", false) == U"pay sam");
+    assert(normalize_confusables(std::u32string(1, char32_t(0x110000))) == U"\uFFFD");
+
+    auto found = contains_confusables(input);
+    assert(found.count(u"\u0430") == 1 && found.count(u"\U0001D42C") == 1);
+    assert(contains_confusables(U"p\u0430y").count(U"\u0430") == 1);
+
+    assert(unicode_normalize(u"e\u0301", NormalizationType::NFC, false) == u"\u00E9");
+    assert(unicode_normalize(u"\xD800\u0301", NormalizationType::NFC, false) == u"\uFFFD\u0301");
+    assert(unicode_normalize(U"\uFB01\u200B!", NormalizationType::NFKC, true) == U"fi!");
+}
+
+void test_confusables_of() {
+    ConfusableList sources = confusables_of("a");
+    if (std::find(sources.begin(), sources.end(), U'\u0430') == sources.end()) {
+        std::cout << "[FAIL] test_confusables_of:\n  got:      " << sources.size() << " sources without Cyrillic 'a'\n  expected: Cyrillic 'a' among them\n";
+        std::cout.flush();
+        return;
+    }
+    ConfusableList folded = confusables_of("a", true);
+    assert(std::find(folded.begin(), folded.end(), U'A') != folded.end());
+    assert(std::find(folded.begin(), folded.end(), U'\u0410') != folded.end());  // Cyrillic capital 'А'
+    assert(confusables_of("no such canonical").empty());
+
+    // Every row, in both modes: each source normalizes back to its canonical string, sources are in codepoint
+    // order, and every codepoint that normalize_confusables changes is listed under its result
+    for (bool fold_case : {false, true}) {
+        const auto& table = fold_case ? CONFUSABLE_TO_CANONICAL_FOLDED : CONFUSABLE_TO_CANONICAL;
+        std::unordered_set<std::string> canonicals;
+        for (const auto& kv : table) {
+            canonicals.insert(kv.second);
+        }
+        size_t listed = 0;
+        for (const auto& canonical : canonicals) {
+            ConfusableList row = confusables_of(canonical, fold_case);
+            for (size_t i = 0; i < row.size(); ++i) {
+                std::string normalized = normalize_confusables(utf8_utils::codepoint_to_utf8(row[i]), fold_case);
+                if (normalized != canonical) {
+                    std::cout << "[FAIL] test_confusables_of: U+" << std::hex << static_cast<uint32_t>(row[i]) << std::dec
+                              << " is listed under '" << canonical << "' but normalizes to '" << normalized << "'\n";
+                    std::cout.flush();
+                    return;
+                }
+                assert(i == 0 || row[i - 1] < row[i]);
+            }
+            listed += row.size();
+        }
+        size_t changed = 0;
+        for (char32_t cp = 0; cp < 0x110000; ++cp) {
+            if (cp >= 0xD800 && cp <= 0xDFFF) {
+                continue;
+            }
+            std::string utf8 = utf8_utils::codepoint_to_utf8(cp);
+            if (normalize_confusables(utf8, fold_case) != utf8) {
+                ++changed;
+            }
+        }
+        assert(listed == changed);
+    }
+}
+
+void test_variant_generator() {
+    size_t a_count = confusables_of("a").size();
+    size_t b_count = confusables_of("b").size();
+    VariantGenerator all("ab");
+    if (all.count() != (a_count + 1) * (b_count + 1)) {
+        std::cout << "[FAIL] test_variant_generator:\n  got:      " << all.count() << " variants\n  expected: "
+                  << (a_count + 1) * (b_count + 1) << "\n";
+        std::cout.flush();
+        return;
+    }
+    std::string variant;
+    size_t produced = 0;
+    while (all.next(variant)) {
+        assert(normalize_confusables(variant) == "ab");
+        ++produced;
+    }
+    assert(produced == all.count());
+    all.variant_at(0, variant);
+    assert(variant == "ab");
+
+    // Skip-ahead matches streaming
+    VariantGenerator streamed("ab");
+    streamed.seek(7);
+    std::string at_seven;
+    all.variant_at(7, at_seven);
+    assert(streamed.next(variant) && variant == at_seven && streamed.position() == 8);
+
+    VariantOptions options;
+    options.max_substitutions = 1;
+    assert(VariantGenerator("ab", options).count() == 1 + a_count + b_count);
+    options.max_count = 3;
+    assert(VariantGenerator("ab", options).count() == 3);
+
+    // Only Cyrillic look-alikes: every replaced (non-ASCII) codepoint must be Cyrillic
+    VariantOptions cyrillic;
+    cyrillic.allowed_scripts = {USCRIPT_CYRILLIC};
+    VariantGenerator restricted("ab", cyrillic);
+    while (restricted.next(variant)) {
+        icu::UnicodeString text = icu::UnicodeString::fromUTF8(variant);
+        for (int32_t i = 0; i < text.length(); i += U16_LENGTH(text.char32At(i))) {
+            assert(text.char32At(i) < 0x80 || uscript_hasScript(text.char32At(i), USCRIPT_CYRILLIC));
+        }
+    }
+    assert(restricted.count() < all.count());
+
+    // Emoji terms and runs of several codepoints: every variant normalizes back, and a single look-alike may
+    // stand for a whole run (U+01C6 'ǆ' for "dž", the canonical form of 'ǆ' itself)
+    for (const char* term : {"\xF0\x9F\x98\x80!", "\xC7\x86"}) {
+        VariantGenerator generator(term);
+        std::string canonical = normalize_confusables(term);
+        bool has_digraph = false;
+        std::unordered_set<std::string> seen;
+        while (generator.next(variant)) {
+            assert(seen.insert(variant).second);
+            if (normalize_confusables(variant) != canonical) {
+                std::cout << "[FAIL] test_variant_generator:\n  variant '" << variant << "' of '" << term
+                          << "' normalizes to '" << normalize_confusables(variant) << "'\n";
+                std::cout.flush();
+                return;
+            }
+            has_digraph = has_digraph || variant == "\xC7\x86";
+        }
+        assert(generator.position() == generator.count() && generator.count() >= 1);
+        assert(has_digraph == (canonical == "d\xC5\xBE"));
+    }
+    // A run counts as one substitution: 'ǳ' (U+01F3) is one look-alike of "dz"
+    VariantOptions one;
+    one.max_substitutions = 1;
+    VariantGenerator digraph("dz", one);
+    bool found_digraph = false;
+    while (digraph.next(variant)) {
+        found_digraph = found_digraph || variant == "\xC7\xB3";
+    }
+    assert(found_digraph);
+}
+
+// Evaluated by the compiler: Cyrillic 'а' and a fullwidth 'Ｐ'
+static_assert(compile_time::normalized_size("p\xD0\xB0ypal") == 6);
+static_assert(compile_time::normalize_confusables<6>("p\xD0\xB0ypal").view() == "paypal");
+static_assert(confusable_literal<"\xEF\xBC\xB0" "ayPal", true>.view() == "paypal");
+static_assert(confusable_name_set<"root", "\xD0\xB0" "dmin">::contains("admin"));
+static_assert(!confusable_name_set<"root", "admin">::contains("\xD0\xB0" "dmin"));
+
+void test_compile_time_tables() {
+    // The constexpr tables must agree with the runtime tables for every codepoint, in both modes
+    for (bool fold_case : {false, true}) {
+        for (char32_t cp = 0; cp < 0x110000; ++cp) {
+            if (cp >= 0xD800 && cp <= 0xDFFF) {
+                continue;
+            }
+            std::string utf8 = utf8_utils::codepoint_to_utf8(cp);
+            std::string expected = normalize_confusables(utf8, fold_case);
+            auto actual = compile_time::normalize_confusables<64>(utf8, fold_case);
+            if (actual.view() != expected) {
+                std::cout << "[FAIL] test_compile_time_tables at U+" << std::hex << static_cast<uint32_t>(cp) << std::dec
+                          << ":\n  got:      '" << actual.view() << "'\n  expected: '" << expected << "'\n";
+                std::cout.flush();
+                return;
+            }
+        }
+    }
+    // Ill-formed input decodes the same way
+    std::string ill_formed = "a\xFF\xE2\x82 \xF0\x9D\x90\xC3\xA9\xED\xA0\x80";
+    assert(compile_time::normalize_confusables<64>(ill_formed).view() == normalize_confusables(ill_formed));
+    assert(compile_time::normalized_size(ill_formed) == normalize_confusables(ill_formed).size());
+}
+
+// Plain O(mn) Levenshtein distance over the canonical codepoints, as reference
+static size_t reference_distance(const std::u32string& a, const std::u32string& b) {
+    std::u32string ca = normalize_confusables(a);
+    std::u32string cb = normalize_confusables(b);
+    std::vector<size_t> row(cb.size() + 1);
+    for (size_t j = 0; j <= cb.size(); ++j) {
+        row[j] = j;
+    }
+    for (size_t i = 1; i <= ca.size(); ++i) {
+        size_t diagonal = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= cb.size(); ++j) {
+            size_t above = row[j];
+            row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + (ca[i - 1] != cb[j - 1])});
+            diagonal = above;
+        }
+    }
+    return row[cb.size()];
+}
+
+static std::string to_utf8(const std::u32string& text) {
+    std::string utf8;
+    for (char32_t cp : text) {
+        utf8 += utf8_utils::codepoint_to_utf8(cp);
+    }
+    return utf8;
+}
+
+void test_confusable_distance() {
+    // Cyrillic 'а' folds onto 'a'; '1'/'l' and '-'/'_' remain two edits
+    assert(confusable_distance("paypa1-support", "p\xD0\xB0ypal_support", 5) == 2);
+    assert(confusable_distance("p\xD0\xB0ypal", "paypal", 0) == 0);
+    assert(confusable_distance("paypal", "PAYPAL", 10) == 6);
+    assert(confusable_distance("paypal", "PAYPAL", 10, true) == 0);
+    assert(confusable_distance("paypal", "PAYPAL", 3) == 4);
+    assert(confusable_distance("", "abc", 10) == 3);
+    assert(confusable_distance("", "", 0) == 0);
+    assert(confusable_distance("abcdef", "a", 2) == 3);
+
+    // Random pairs against the reference, across single- and multi-word patterns and with or without a cutoff
+    const char32_t alphabet[] = {U'a', U'b', U'l', U'1', U'-', U'_', 0x0430, 0x217C, 0xFB01, 0x00E9, 0x1D41A};
+    std::mt19937 rng(38);
+    auto random_text = [&](size_t length) {
+        std::u32string text;
+        for (size_t i = 0; i < length; ++i) {
+            text.push_back(alphabet[rng() % (sizeof(alphabet) / sizeof(alphabet[0]))]);
+        }
+        return text;
+    };
+    const size_t limits[] = {0, 1, 3, 10, 40, std::numeric_limits<size_t>::max()};
+    for (int round = 0; round < 300; ++round) {
+        std::u32string a = random_text(rng() % 200);
+        // Mostly near-duplicates of a, so small limits are exercised on long strings too
+        std::u32string b = a;
+        if (round % 4 == 0) {
+            b = random_text(rng() % 200);
+        } else {
+            for (size_t edits = rng() % 8; edits > 0; --edits) {
+                size_t at = b.empty() ? 0 : rng() % b.size();
+                switch (rng() % 3) {
+                    case 0: b.insert(b.begin() + at, alphabet[rng() % 11]); break;
+                    case 1: if (!b.empty()) b.erase(b.begin() + at); break;
+                    default: if (!b.empty()) b[at] = alphabet[rng() % 11]; break;
+                }
+            }
+        }
+        size_t expected = reference_distance(a, b);
+        for (size_t max_k : limits) {
+            size_t actual = confusable_distance(to_utf8(a), to_utf8(b), max_k);
+            size_t capped = expected <= max_k ? expected : max_k + 1;
+            if (actual != capped) {
+                std::cout << "[FAIL] test_confusable_distance:\n  got:      " << actual << "\n  expected: " << capped
+                          << " (lengths " << a.size() << ", " << b.size() << ", max_k " << max_k << ")\n";
+                std::cout.flush();
+                return;
+            }
+        }
+    }
+
+    // One-vs-many gives the same results as pairwise calls, for short and long queries
+    for (size_t query_length : {0, 5, 12, 64, 65, 150}) {
+        std::u32string query = random_text(query_length);
+        std::vector<std::string> candidates;
+        for (int i = 0; i < 50; ++i) {
+            std::u32string candidate = query.substr(0, rng() % (query.size() + 1)) + random_text(rng() % 20);
+            candidates.push_back(to_utf8(candidate));
+        }
+        candidates.push_back("");
+        std::vector<std::string_view> views(candidates.begin(), candidates.end());
+        for (size_t max_k : limits) {
+            std::vector<size_t> batch = confusable_distances(to_utf8(query), views, max_k);
+            assert(batch.size() == candidates.size());
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                assert(batch[i] == confusable_distance(to_utf8(query), candidates[i], max_k));
+            }
+        }
+    }
+}
+
+void test_analyze() {
+    Analysis latin = analyze("paypal");
+    assert(latin.confusables.empty() && latin.restriction_level == RestrictionLevel::ASCII_ONLY);
+    assert(latin.resolved_scripts.contains(USCRIPT_LATIN) && !latin.mixed_script());
+
+    // Latin with a Cyrillic 'а': mixed script, and the Cyrillic letter is a confusable
+    Analysis spoof = analyze("p\xD0\xB0ypal");
+    assert(spoof.mixed_script() && spoof.restriction_level == RestrictionLevel::MINIMALLY_RESTRICTIVE);
+    assert(spoof.confusables == contains_confusables("p\xD0\xB0ypal"));
+
+    // All Cyrillic, digits and punctuation are Common
+    Analysis cyrillic = analyze("\xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82-2024");
+    assert(cyrillic.restriction_level == RestrictionLevel::SINGLE_SCRIPT);
+    assert(cyrillic.resolved_scripts.scripts() == std::vector<UScriptCode>{USCRIPT_CYRILLIC});
+
+    // Latin + Han + Hiragana is Japanese; Latin + Devanagari is moderately restrictive
+    assert(analyze("abc\xE6\x9D\xB1\xE3\x81\x82").restriction_level == RestrictionLevel::HIGHLY_RESTRICTIVE);
+    assert(analyze("abc\xE0\xA4\x95").restriction_level == RestrictionLevel::MODERATELY_RESTRICTIVE);
+    assert(analyze("").resolved_scripts.is_all());
+    assert(script_set_of(U'1').is_all() && !script_set_of(U'a').is_all());
+
+    // The generated table equals ICU's script extensions with the UTS #39 augmentation, for every codepoint
+    for (char32_t cp = 0; cp < 0x110000; ++cp) {
+        UScriptCode scripts[64];
+        UErrorCode status = U_ZERO_ERROR;
+        int32_t count = uscript_getScriptExtensions(static_cast<UChar32>(cp), scripts, 64, &status);
+        uint64_t words[ScriptSet::WORDS] = {};
+        auto add = [&](UScriptCode script) { words[script / 64] |= uint64_t(1) << (script % 64); };
+        bool everything = false;
+        for (int32_t i = 0; i < count; ++i) {
+            add(scripts[i]);
+            everything = everything || scripts[i] == USCRIPT_COMMON || scripts[i] == USCRIPT_INHERITED;
+            if (scripts[i] == USCRIPT_HAN) {
+                add(USCRIPT_HAN_WITH_BOPOMOFO);
+                add(USCRIPT_JAPANESE);
+                add(USCRIPT_KOREAN);
+            } else if (scripts[i] == USCRIPT_HIRAGANA || scripts[i] == USCRIPT_KATAKANA) {
+                add(USCRIPT_JAPANESE);
+            } else if (scripts[i] == USCRIPT_HANGUL) {
+                add(USCRIPT_KOREAN);
+            } else if (scripts[i] == USCRIPT_BOPOMOFO) {
+                add(USCRIPT_HAN_WITH_BOPOMOFO);
+            }
+        }
+        ScriptSet expected = everything ? ScriptSet::all() : ScriptSet(words);
+        if (!(script_set_of(cp) == expected)) {
+            std::cout << "[FAIL] test_analyze: U+" << std::hex << static_cast<uint32_t>(cp) << std::dec
+                      << " has " << script_set_of(cp).scripts().size() << " scripts, expected "
+                      << expected.scripts().size() << "\n";
+            std::cout.flush();
+            return;
+        }
+    }
+
+    // Restriction levels agree with ICU's spoof checker (all characters allowed) on random mixes
+    UErrorCode status = U_ZERO_ERROR;
+    USpoofChecker* checker = uspoof_open(&status);
+    uspoof_setChecks(checker, USPOOF_RESTRICTION_LEVEL | USPOOF_AUX_INFO, &status);
+    uspoof_setRestrictionLevel(checker, USPOOF_ASCII);
+    icu::UnicodeSet everything(0, 0x10FFFF);
+    uspoof_setAllowedUnicodeSet(checker, &everything, &status);
+    USpoofCheckResult* check = uspoof_openCheckResult(&status);
+    assert(U_SUCCESS(status));
+    const char32_t pool[] = {U'a', U'Z', U'1', U'-', 0x00E9, 0x0430, 0x03B1, 0x6771, 0x3042, 0x30A2, 0xAC00,
+                             0x3105, 0x0915, 0x13A0, 0x0301, 0x3001, 0x0660, 0x1D41A};
+    std::mt19937 rng(39);
+    const RestrictionLevel expected_levels[] = {
+        RestrictionLevel::ASCII_ONLY, RestrictionLevel::SINGLE_SCRIPT, RestrictionLevel::HIGHLY_RESTRICTIVE,
+        RestrictionLevel::MODERATELY_RESTRICTIVE, RestrictionLevel::MINIMALLY_RESTRICTIVE};
+    const URestrictionLevel icu_levels[] = {USPOOF_ASCII, USPOOF_SINGLE_SCRIPT_RESTRICTIVE, USPOOF_HIGHLY_RESTRICTIVE,
+                                            USPOOF_MODERATELY_RESTRICTIVE, USPOOF_MINIMALLY_RESTRICTIVE};
+    for (int round = 0; round < 2000; ++round) {
+        std::string text;
+        for (size_t length = 1 + rng() % 4; length > 0; --length) {
+            text += utf8_utils::codepoint_to_utf8(pool[rng() % (sizeof(pool) / sizeof(pool[0]))]);
+        }
+        uspoof_check2UTF8(checker, text.c_str(), static_cast<int32_t>(text.size()), check, &status);
+        URestrictionLevel icu_level = uspoof_getCheckResultRestrictionLevel(check, &status);
+        RestrictionLevel level = analyze(text).restriction_level;
+        size_t index = 0;
+        while (expected_levels[index] != level) {
+            ++index;
+        }
+        if (icu_levels[index] != icu_level) {
+            std::cout << "[FAIL] test_analyze: restriction level of '" << text << "' is " << index
+                      << ", ICU says " << std::hex << icu_level << std::dec << "\n";
+            std::cout.flush();
+            break;
+        }
+    }
+    assert(U_SUCCESS(status));
+    uspoof_closeCheckResult(check);
+    uspoof_close(checker);
+}
+
+void test_record_field_rewriter() {
+    auto normalize = [](std::string_view value, std::string& out) { out = normalize_confusables(value); };
+
+    // JSONL: only the selected top-level string values change; escapes are decoded and re-encoded
+    RecordFieldRewriter jsonl(RecordFormat::JSONL, {"name", "bio"});
+    std::string out;
+    std::string record = "{\"id\": \"p\xD0\xB0y\", \"name\":\"p\xD0\xB0yp\xD0\xB0l\", \"n\\u0061me2\": 1.5e3, "
+                         "\"nested\": {\"name\": \"\xD0\xB0\"}, \"bio\": \"\\u0440\\u0430y \\\"x\\\"\"}";
+    assert(jsonl.rewrite(record, normalize, out));
+    std::string expected = "{\"id\": \"p\xD0\xB0y\", \"name\":\"paypal\", \"n\\u0061me2\": 1.5e3, "
+                           "\"nested\": {\"name\": \"\xD0\xB0\"}, \"bio\": \"pay \\\"x\\\"\"}";
+    if (out != expected) {
+        std::cout << "[FAIL] test_record_field_rewriter:\n  got:      '" << out << "'\n  expected: '" << expected << "'\n";
+        std::cout.flush();
+        return;
+    }
+    // Unchanged values keep their original escapes; a replacement producing a backslash is escaped
+    out.clear();
+    assert(jsonl.rewrite("{\"name\":\"caf\\u00e9!\",\"bio\":\"\xEF\xBC\xBC\"}", normalize, out));
+    assert(out == "{\"name\":\"cafe!\",\"bio\":\"\\\\\"}");
+    out.clear();
+    assert(jsonl.rewrite("{\"name\":\"a\\u0062\"}", normalize, out) && out == "{\"name\":\"a\\u0062\"}");
+    // Escaped keys are matched by their decoded name
+    out.clear();
+    assert(jsonl.rewrite("{\"n\\u0061me\":\"\xD0\xB0\"}", normalize, out) && out == "{\"n\\u0061me\":\"a\"}");
+    // Malformed records are copied unchanged; blank lines are fine
+    for (std::string_view bad : {"not json", "{\"name\": \"\xD0\xB0\"", "{\"name\" \"x\"}", "[\"\xD0\xB0\"]"}) {
+        out.clear();
+        assert(!jsonl.rewrite(bad, normalize, out) && out == bad);
+    }
+    out.clear();
+    assert(jsonl.rewrite("  ", normalize, out) && out == "  ");
+    std::vector<std::string> visited;
+    assert(jsonl.visit("{\"name\":\"\\u0430\",\"other\":\"\xD0\xB0\"}", [&](std::string_view v) { visited.emplace_back(v); }));
+    assert(visited == std::vector<std::string>{"\xD0\xB0"});
+
+    // CSV: columns chosen by header name; a value that now contains a comma gets quoted
+    RecordFieldRewriter csv(RecordFormat::CSV, {"name", "note", "absent"});
+    assert(csv.expects_header() && csv.read_header("id,\"name\",note\r") && !csv.expects_header());
+    assert(csv.missing_fields() == std::vector<std::string>{"absent"});
+    out.clear();
+    assert(csv.rewrite("p\xD0\xB0y,a\xE2\x80\x9A" "b,\"say \"\"\xD0\xB0\"\"\"\r", normalize, out));
+    assert(out == "p\xD0\xB0y,\"a,b\",\"say \"\"a\"\"\"\r");
+    assert(!csv.record_complete("1,\"multi") && csv.record_complete("1,\"multi\nline\",x"));
+    // A bare quote inside an unquoted field is text, not the start of a multi-line record
+    assert(csv.record_complete("1,5\" screen") && csv.record_complete("1,\"a \"\"b\"\"\",x\""));
+    assert(!csv.record_complete("1,\"a \"\"b\"\",x"));
+    out.clear();
+    assert(csv.rewrite("1,5\" \xD0\xB0,x", normalize, out) && out == "1,\"5\"\" a\",x");
+    out.clear();
+    assert(csv.rewrite("1,\"multi\n\xD0\xB0\",x", normalize, out) && out == "1,\"multi\na\",x");
+    out.clear();
+    assert(!csv.rewrite("1,\"x\"y,z", normalize, out) && out == "1,\"x\"y,z");
+
+    // TSV: every column when no fields are given; tabs produced by a replacement become spaces
+    RecordFieldRewriter tsv(RecordFormat::TSV, {});
+    assert(tsv.read_header("name\tbio"));
+    out.clear();
+    assert(tsv.rewrite("p\xD0\xB0l\t\xF0\x9F\x85\xAD", normalize, out));
+    std::string emblem = normalize_confusables("\xF0\x9F\x85\xAD");
+    std::replace(emblem.begin(), emblem.end(), '\t', ' ');
+    assert(out == "pal\t" + emblem);
+}
+
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+void test_normalization_server() {
+    ServerOptions options;
+    options.worker_threads = 3;
+    options.max_batch = 4;  // many small batches, so responses finish out of order and must be reordered
+    NormalizationServer server(options);
+    std::string path = "/tmp/unicode_confusables_test_" + std::to_string(getpid()) + ".sock";
+    if (!server.listen(path)) {
+        std::cout << "[FAIL] test_normalization_server: " << server.error() << "\n";
+        std::cout.flush();
+        return;
+    }
+    struct stat socket_status;
+    assert(stat(path.c_str(), &socket_status) == 0 && (socket_status.st_mode & 07777) == 0600);
+    std::thread loop([&server] { server.run(); });
+
+    NormalizationClient client;
+    assert(client.connect(path));
+    std::string out;
+    assert(client.normalize_confusables("P\xD0\x90YP\xD0\x90L", out, true) && out == "paypal");
+    std::unordered_set<std::string> found;
+    assert(client.contains_confusables("p\xD0\xB0y\xC9\xA1", found) && found == contains_confusables("p\xD0\xB0y\xC9\xA1"));
+
+    // Pipelined requests on several connections match the library
+    const std::vector<std::string> samples = {"", "plain ascii", "\xD0\x9D\xD0\xB5ll\xD0\xBE W\xD0\xBErld",
+                                              "\xF0\x9D\x90\x87\xF0\x9D\x90\x9E", "ﬁle café", "\xEF\xBC\xA1\xEF\xBC\xA2"};
+    auto check_connection = [&](size_t seed, bool& ok) {
+        NormalizationClient pipelined;
+        ok = pipelined.connect(path);
+        std::vector<protocol::Request> requests;
+        for (size_t i = 0; i < 300; ++i) {
+            const std::string& sample = samples[(i + seed) % samples.size()];
+            switch (i % 4) {
+                case 0: requests.push_back({protocol::Operation::NORMALIZE_CONFUSABLES, 0, sample}); break;
+                case 1: requests.push_back({protocol::Operation::NORMALIZE_CONFUSABLES, protocol::FLAG_FOLD_CASE | (3 << protocol::NORMALIZATION_SHIFT), sample}); break;
+                case 2: requests.push_back({protocol::Operation::CONTAINS_CONFUSABLES, 0, sample}); break;
+                default: requests.push_back({protocol::Operation::PING, 0, sample}); break;
+            }
+        }
+        std::vector<protocol::Response> responses;
+        ok = ok && pipelined.call(requests, responses);
+        for (size_t i = 0; ok && i < requests.size(); ++i) {
+            const std::string& payload = requests[i].payload;
+            std::string expected = payload;
+            if (i % 4 == 0) {
+                expected = normalize_confusables(payload);
+            } else if (i % 4 == 1) {
+                expected = normalize_confusables(unicode_normalize(payload, NormalizationType::NFKC, true), true);
+            } else if (i % 4 == 2) {
+                auto set = contains_confusables(payload);
+                std::vector<std::string> sorted(set.begin(), set.end());
+                std::sort(sorted.begin(), sorted.end());
+                expected.clear();
+                for (const auto& c : sorted) expected += c;
+            }
+            ok = responses[i].id == i && responses[i].status == protocol::Status::OK && responses[i].payload == expected;
+        }
+    };
+    bool ok_a = false, ok_b = false;
+    std::thread other([&] { check_connection(1, ok_b); });
+    check_connection(0, ok_a);
+    other.join();
+    if (!ok_a || !ok_b) {
+        std::cout << "[FAIL] test_normalization_server: pipelined responses differ from the library\n";
+        std::cout.flush();
+    }
+    assert(ok_a && ok_b);
+
+    // Unknown operations and flags are rejected without closing the connection
+    std::vector<protocol::Response> responses;
+    assert(client.call({{static_cast<protocol::Operation>(9), 0, "x"},
+                        {protocol::Operation::CONTAINS_CONFUSABLES, protocol::FLAG_FOLD_CASE, "x"},
+                        {protocol::Operation::NORMALIZE_CONFUSABLES, 5 << protocol::NORMALIZATION_SHIFT, "x"},
+                        {protocol::Operation::PING, 0, "still here"}},
+                       responses));
+    assert(responses[0].status == protocol::Status::BAD_REQUEST && responses[1].status == protocol::Status::BAD_REQUEST);
+    assert(responses[2].status == protocol::Status::BAD_REQUEST);
+    assert(responses[3].status == protocol::Status::OK && responses[3].payload == "still here");
+
+    // A single call is refused, without closing, while a request queued with send() is unanswered
+    client.send(protocol::Operation::PING, 0, "queued");
+    assert(!client.normalize_confusables("x", out) && client.connected());
+    protocol::Response queued;
+    assert(client.receive(queued) && queued.payload == "queued");
+    // U+FDFA expands tenfold
+    assert(client.normalize_confusables("\xEF\xB7\xBA", out) && out == normalize_confusables("\xEF\xB7\xBA"));
+
+    // An oversized frame is answered in order with TOO_LARGE, then the connection closes
+    int raw = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    assert(connect(raw, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    std::string frames;
+    protocol::append_frame(frames, 7, static_cast<uint8_t>(protocol::Operation::PING), 0, "ok");
+    protocol::append_frame(frames, 8, static_cast<uint8_t>(protocol::Operation::PING), 0, "");
+    frames[frames.size() - 7] = 0x7F;  // payload length of the second frame: far above MAX_PAYLOAD
+    assert(write(raw, frames.data(), frames.size()) == static_cast<ssize_t>(frames.size()));
+    std::string received;
+    char buffer[256];
+    for (ssize_t n; (n = read(raw, buffer, sizeof(buffer))) > 0;) {
+        received.append(buffer, static_cast<size_t>(n));
+    }
+    close(raw);
+    assert(received.size() == 2 * protocol::HEADER_SIZE + 2);
+    protocol::FrameHeader first = protocol::read_header(received.data());
+    protocol::FrameHeader second = protocol::read_header(received.data() + protocol::HEADER_SIZE + 2);
+    assert(first.id == 7 && first.code == static_cast<uint8_t>(protocol::Status::OK));
+    assert(second.id == 8 && second.code == static_cast<uint8_t>(protocol::Status::TOO_LARGE));
+
+    server.stop();
+    loop.join();
+    assert(access(path.c_str(), F_OK) != 0);
+    assert(!client.normalize_confusables("x", out));
+}
+#endif
+
 void test_nfkd_normalization() {
     std::string input = "caf\xC3\xA9"; // UTF-8 for café
     std::string expected = "cafe\xCC\x81"; // UTF-8 for 'e' + U+0301
@@ -201,6 +968,23 @@ int main() {
     test_cyrillic_confusable();
     test_greek_confusable();
     test_ascii_negative();
+    test_fold_case_confusable();
+    test_normalize_into_buffer();
+    test_normalize_inplace();
+    test_cached_results();
+    test_blocklist_matcher();
+    test_offset_map();
+    test_incremental_normalizer();
+    test_utf16_utf32_variants();
+    test_confusables_of();
+    test_variant_generator();
+    test_compile_time_tables();
+    test_confusable_distance();
+    test_analyze();
+    test_record_field_rewriter();
+#ifdef UNICODE_CONFUSABLES_HAS_SERVER
+    test_normalization_server();
+#endif
     test_nfkd_normalization();
     test_nfd_normalization();
     test_nfd_vs_nfkd();
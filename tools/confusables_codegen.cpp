@@ -7,10 +7,16 @@
 #include <sstream>
 #include <iomanip>
 #include <cctype>
+#include <cstdint>
+#include <algorithm>
+#include <tuple>
 #include "utf8_utils.h"
 #include <functional>
+#include <map>
+#include <unicode/uchar.h>
 #include <unicode/unistr.h>
 #include <unicode/normalizer2.h>
+#include <unicode/uscript.h>
 
 // This tool generates C++ header and source files from a confusables data file.
 
@@ -21,6 +27,9 @@
 // The output will be two files:
 // 1. unicode_confusables_data.h - a header file with declarations of the confusable mappings.
 // 2. unicode_confusables_data.cpp - a source file with the actual mappings initialized.
+// Both also carry the script set of every codepoint (UTS #39), used by analyze().
+// Optionally a third file:
+// 3. unicode_confusables_constexpr_data.h - the same mappings as sorted constexpr arrays, for compile-time use.
 // The generated code will use ICU for Unicode handling and normalization.
 
 static std::unordered_set<char32_t> acceptable_emoji_set = {
@@ -77,11 +86,191 @@ std::string escape_cpp_string(const std::string &str)
     return oss.str();
 }
 
+// Like escape_cpp_string, but also escapes non-ASCII bytes (as 3-digit octal, which cannot run into the next character)
+static std::string escape_cpp_bytes(const std::string &str)
+{
+    std::ostringstream oss;
+    for (unsigned char c : str)
+    {
+        if (c < 0x20 || c >= 0x7F || c == '"' || c == '\\' || c == '?')
+            oss << '\\' << std::oct << std::setw(3) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        else
+            oss << static_cast<char>(c);
+    }
+    return oss.str();
+}
+
+// Writes codepoint-keyed tables as sorted constexpr arrays (binary searchable in constant expressions).
+// Multi-codepoint keys are left out: normalization looks up one codepoint at a time.
+static void write_constexpr_tables(std::ostream &ofs, const std::string &input_file,
+                                   const std::vector<std::pair<std::string, const std::unordered_map<std::string, std::string>*>> &tables)
+{
+    ofs << "#pragma once\n\n";
+    ofs << "// Auto-generated from " << input_file << "\n";
+    ofs << "#include <cstddef>\n#include <cstdint>\n\n";
+    ofs << "namespace unicode_confusables {\nnamespace constexpr_data {\n\n";
+    ofs << "// Canonical UTF-8 for source is CANONICAL_BYTES[offset, offset + length)\n";
+    ofs << "struct Entry {\n    char32_t source;\n    uint32_t offset;\n    uint32_t length;\n};\n\n";
+
+    std::string bytes;
+    std::unordered_map<std::string, size_t> offsets;
+    std::vector<std::vector<std::tuple<char32_t, size_t, size_t>>> rows(tables.size());
+    for (size_t t = 0; t < tables.size(); ++t) {
+        for (const auto& kv : *tables[t].second) {
+            icu::UnicodeString key = icu::UnicodeString::fromUTF8(kv.first);
+            if (key.countChar32() != 1) continue;
+            auto found = offsets.find(kv.second);
+            if (found == offsets.end()) {
+                found = offsets.emplace(kv.second, bytes.size()).first;
+                bytes += kv.second;
+            }
+            rows[t].emplace_back(static_cast<char32_t>(key.char32At(0)), found->second, kv.second.size());
+        }
+        std::sort(rows[t].begin(), rows[t].end());
+    }
+
+    ofs << "inline constexpr char CANONICAL_BYTES[] =\n";
+    for (size_t i = 0; i < bytes.size(); i += 64) {
+        ofs << "    \"" << escape_cpp_bytes(bytes.substr(i, 64)) << "\"\n";
+    }
+    ofs << "    \"\";\n\n";
+    for (size_t t = 0; t < tables.size(); ++t) {
+        ofs << "inline constexpr Entry " << tables[t].first << "[] = {\n";
+        for (const auto& row : rows[t]) {
+            ofs << "    {0x" << std::hex << static_cast<uint32_t>(std::get<0>(row)) << std::dec << ", "
+                << std::get<1>(row) << ", " << std::get<2>(row) << "},\n";
+        }
+        ofs << "};\n\n";
+    }
+    ofs << "} // namespace constexpr_data\n} // namespace unicode_confusables\n";
+}
+
+// Writes the UTS #39 augmented script extensions of every codepoint: bitsets indexed by UScriptCode, where
+// Han also implies Hanb, Jpan and Kore (Hiragana/Katakana Jpan, Hangul Kore, Bopomofo Hanb) and Common or
+// Inherited means every script. Codepoints reach their set through a two-stage table of deduplicated blocks.
+static bool write_script_sets(std::ostream &ofs_header, std::ostream &ofs_cpp)
+{
+    const size_t script_limit = static_cast<size_t>(u_getIntPropertyMaxValue(UCHAR_SCRIPT)) + 1;
+    const size_t words = (std::max<size_t>(script_limit, USCRIPT_HAN_WITH_BOPOMOFO + 1) + 63) / 64;
+    const unsigned shift = 7;
+    const UChar32 block_size = 1 << shift;
+
+    std::map<std::vector<uint64_t>, size_t> set_ids;
+    std::vector<const std::vector<uint64_t>*> sets;
+    std::map<std::vector<uint16_t>, size_t> block_ids;
+    std::vector<const std::vector<uint16_t>*> blocks;
+    std::vector<uint16_t> stage1;
+    for (UChar32 start = 0; start < 0x110000; start += block_size) {
+        std::vector<uint16_t> block(block_size);
+        for (UChar32 cp = start; cp < start + block_size; ++cp) {
+            UScriptCode scripts[64];
+            UErrorCode status = U_ZERO_ERROR;
+            int32_t count = uscript_getScriptExtensions(cp, scripts, 64, &status);
+            if (U_FAILURE(status)) {
+                std::cerr << "uscript_getScriptExtensions failed for U+" << std::hex << cp << std::dec << "\n";
+                return false;
+            }
+            std::vector<uint64_t> set(words, 0);
+            auto add = [&](UScriptCode script) { set[script / 64] |= uint64_t(1) << (script % 64); };
+            auto has = [&](UScriptCode script) { return (set[script / 64] >> (script % 64)) & 1; };
+            for (int32_t i = 0; i < count; ++i) add(scripts[i]);
+            if (has(USCRIPT_HAN)) {
+                add(USCRIPT_HAN_WITH_BOPOMOFO);
+                add(USCRIPT_JAPANESE);
+                add(USCRIPT_KOREAN);
+            }
+            if (has(USCRIPT_HIRAGANA) || has(USCRIPT_KATAKANA)) add(USCRIPT_JAPANESE);
+            if (has(USCRIPT_HANGUL)) add(USCRIPT_KOREAN);
+            if (has(USCRIPT_BOPOMOFO)) add(USCRIPT_HAN_WITH_BOPOMOFO);
+            if (has(USCRIPT_COMMON) || has(USCRIPT_INHERITED)) std::fill(set.begin(), set.end(), ~uint64_t(0));
+            auto found = set_ids.emplace(set, sets.size());
+            if (found.second) sets.push_back(&found.first->first);
+            block[cp - start] = static_cast<uint16_t>(found.first->second);
+        }
+        auto found = block_ids.emplace(block, blocks.size());
+        if (found.second) blocks.push_back(&found.first->first);
+        stage1.push_back(static_cast<uint16_t>(found.first->second));
+    }
+    if (sets.size() > 0xFFFF || blocks.size() > 0xFFFF) {
+        std::cerr << "Script set table does not fit 16-bit indexes\n";
+        return false;
+    }
+
+    ofs_header << "// Script set of every codepoint (UTS #39 augmented script extensions, Common and Inherited as every\n";
+    ofs_header << "// script), as bitsets indexed by UScriptCode. The set of cp is\n";
+    ofs_header << "// SCRIPT_SETS[SCRIPT_SET_INDEX[(SCRIPT_SET_BLOCKS[cp >> SCRIPT_SET_SHIFT] << SCRIPT_SET_SHIFT) | (cp & SCRIPT_SET_MASK)]]\n";
+    ofs_header << "constexpr size_t SCRIPT_SET_WORDS = " << words << ";\n";
+    ofs_header << "constexpr unsigned SCRIPT_SET_SHIFT = " << shift << ";\n";
+    ofs_header << "constexpr uint32_t SCRIPT_SET_MASK = " << (block_size - 1) << ";\n";
+    ofs_header << "extern const uint16_t SCRIPT_SET_BLOCKS[];\n";
+    ofs_header << "extern const uint16_t SCRIPT_SET_INDEX[];\n";
+    ofs_header << "extern const uint64_t SCRIPT_SETS[][SCRIPT_SET_WORDS];\n\n";
+
+    auto write_numbers = [&](const std::vector<uint16_t>& numbers) {
+        for (size_t i = 0; i < numbers.size(); ++i) {
+            ofs_cpp << (i % 16 == 0 ? "    " : " ") << numbers[i] << ",";
+            if (i % 16 == 15 || i + 1 == numbers.size()) ofs_cpp << "\n";
+        }
+    };
+    ofs_cpp << "const uint16_t SCRIPT_SET_BLOCKS[] = {\n";
+    write_numbers(stage1);
+    ofs_cpp << "};\n\n";
+    ofs_cpp << "const uint16_t SCRIPT_SET_INDEX[] = {\n";
+    std::vector<uint16_t> index;
+    for (const auto* block : blocks) index.insert(index.end(), block->begin(), block->end());
+    write_numbers(index);
+    ofs_cpp << "};\n\n";
+    ofs_cpp << "const uint64_t SCRIPT_SETS[][SCRIPT_SET_WORDS] = {\n";
+    for (const auto* set : sets) {
+        ofs_cpp << "    {";
+        for (size_t w = 0; w < words; ++w) {
+            ofs_cpp << (w ? ", " : "") << "0x" << std::hex << (*set)[w] << std::dec << "ull";
+        }
+        ofs_cpp << "},\n";
+    }
+    ofs_cpp << "};\n\n";
+    std::cout << "Script sets: " << sets.size() << " distinct sets, " << blocks.size() << " distinct blocks of " << block_size << " codepoints.\n";
+    return true;
+}
+
+// Writes a string -> string map as chunked init functions plus the const map definition
+static void write_string_map(std::ostream &ofs_cpp, const std::string &name, const std::string &chunk_prefix,
+                             const std::unordered_map<std::string, std::string> &entries, size_t chunk_size)
+{
+    std::vector<std::vector<std::pair<std::string, std::string>>> chunks;
+    auto it = entries.begin();
+    while (it != entries.end()) {
+        chunks.emplace_back();
+        for (size_t i = 0; i < chunk_size && it != entries.end(); ++i, ++it) {
+            chunks.back().emplace_back(it->first, it->second);
+        }
+    }
+
+    // Generate chunk initialization functions
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        ofs_cpp << "static void init_" << chunk_prefix << "_chunk_" << i << "(std::unordered_map<std::string, std::string>& map) {\n";
+        for (const auto& kv : chunks[i]) {
+            ofs_cpp << "    map[\"" << escape_cpp_string(kv.first) << "\"] = \"" << escape_cpp_string(kv.second) << "\";\n";
+        }
+        ofs_cpp << "}\n\n";
+    }
+
+    // Generate the main map with runtime initialization
+    ofs_cpp << "const std::unordered_map<std::string, std::string> " << name << " = []() {\n";
+    ofs_cpp << "    std::unordered_map<std::string, std::string> map;\n";
+    ofs_cpp << "    map.reserve(" << entries.size() << ");\n";
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        ofs_cpp << "    init_" << chunk_prefix << "_chunk_" << i << "(map);\n";
+    }
+    ofs_cpp << "    return map;\n";
+    ofs_cpp << "}();\n\n";
+}
+
 int main(int argc, char *argv[])
 {
-    if (argc != 4)
+    if (argc != 4 && argc != 5)
     {
-        std::cerr << "Usage: " << argv[0] << " <input_file> <output_header> <output_cpp>\n";
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_header> <output_cpp> [<output_constexpr_header>]\n";
         return 1;
     }
     std::string input_file = argv[1];
@@ -110,11 +299,12 @@ int main(int argc, char *argv[])
     // Write header file
     ofs_header << "#pragma once\n\n";
     ofs_header << "// Auto-generated from " << input_file << "\n";
-    ofs_header << "#include <unordered_map>\n#include <unordered_set>\n#include <string>\n\n";
+    ofs_header << "#include <cstddef>\n#include <cstdint>\n#include <unordered_map>\n#include <string>\n\n";
     ofs_header << "namespace unicode_confusables {\n\n";
     ofs_header << "extern const std::unordered_map<std::string, std::string> CONFUSABLE_TO_CANONICAL;\n";
-    ofs_header << "extern const std::unordered_map<std::string, std::unordered_set<std::string>> CONFUSABLES_MAP;\n\n";
-    ofs_header << "} // namespace unicode_confusables\n";
+    ofs_header << "// Case folding composed with CONFUSABLE_TO_CANONICAL, keyed by single codepoint (includes ASCII)\n";
+    ofs_header << "extern const std::unordered_map<std::string, std::string> CONFUSABLE_TO_CANONICAL_FOLDED;\n";
+    ofs_header << "// The reverse mapping (canonical -> confusables) is derived from these tables on first use, see confusables_of\n\n";
 
     // Write cpp file header
     ofs_cpp << "// Auto-generated from " << input_file << "\n";
@@ -275,11 +465,8 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Build two mappings:
-    // 1. confusable -> canonical (for normalization)
-    // 2. canonical -> set of confusables (for lookup operations)
+    // Build the confusable -> canonical mapping used for normalization
     std::unordered_map<std::string, std::string> confusable_to_canonical;
-    std::unordered_map<std::string, std::unordered_set<std::string>> canonical_to_confusables;
     for (const auto& entry : raw_entries) {
         // if src is ASCII, skip it
         // this is required to avoid adding confusables for ASCII characters. The unicode mapping contains some for roman numerals, but we don't want to add those
@@ -288,86 +475,82 @@ int main(int argc, char *argv[])
             continue;
 
         confusable_to_canonical[entry.first] = entry.second;
-        canonical_to_confusables[entry.second].insert(entry.first);
     }
     // Use runtime initialization instead of large initializer lists for better compile times
     size_t count1 = confusable_to_canonical.size();
-    size_t count2 = 0;
-    for (const auto& kv : canonical_to_confusables) {
-        count2 += kv.second.size();
-    }
-    
+
     // Split data initialization into chunks to improve compilation time
     const size_t CHUNK_SIZE = 500;  // Reduced chunk size for even better compilation performance
-    size_t chunk_num = 0;
     
-    // Generate initialization functions for CONFUSABLE_TO_CANONICAL
-    std::vector<std::vector<std::pair<std::string, std::string>>> confusable_chunks;
-    auto it = confusable_to_canonical.begin();
-    while (it != confusable_to_canonical.end()) {
-        confusable_chunks.emplace_back();
-        for (size_t i = 0; i < CHUNK_SIZE && it != confusable_to_canonical.end(); ++i, ++it) {
-            confusable_chunks.back().emplace_back(it->first, it->second);
+    // Generate CONFUSABLE_TO_CANONICAL with chunked runtime initialization
+    write_string_map(ofs_cpp, "CONFUSABLE_TO_CANONICAL", "confusable_to_canonical", confusable_to_canonical, CHUNK_SIZE);
+
+    // Compose case folding with the confusable mapping so that case-insensitive
+    // canonicalization costs one lookup per codepoint at runtime.
+    // Each codepoint is canonicalized, folded, then canonicalized and folded again
+    // in case folding produced another confusable (e.g. GREEK CAPITAL RHO -> P -> p).
+    auto canonicalize = [&](const icu::UnicodeString& ustr) {
+        icu::UnicodeString out;
+        for (int32_t i = 0; i < ustr.length(); ) {
+            UChar32 cp = ustr.char32At(i);
+            std::string utf8 = unicode_confusables::utf8_utils::codepoint_to_utf8(cp);
+            auto found = confusable_to_canonical.find(utf8);
+            if (found != confusable_to_canonical.end()) {
+                out.append(icu::UnicodeString::fromUTF8(found->second));
+            } else {
+                out.append(cp);
+            }
+            i += U16_LENGTH(cp);
         }
+        return out;
+    };
+    std::unordered_map<std::string, std::string> confusable_to_canonical_folded;
+    for (UChar32 cp = 0; cp <= 0x10FFFF; ++cp) {
+        if (U_IS_SURROGATE(cp)) continue;
+        icu::UnicodeString ustr(cp);
+        icu::UnicodeString folded = canonicalize(canonicalize(ustr).foldCase()).foldCase();
+        if (folded == ustr) continue;
+        std::string src_utf8, dst_utf8;
+        ustr.toUTF8String(src_utf8);
+        folded.toUTF8String(dst_utf8);
+        confusable_to_canonical_folded[src_utf8] = dst_utf8;
     }
-    
-    // Generate chunk initialization functions
-    for (size_t i = 0; i < confusable_chunks.size(); ++i) {
-        ofs_cpp << "static void init_confusable_to_canonical_chunk_" << i << "(std::unordered_map<std::string, std::string>& map) {\n";
-        for (const auto& kv : confusable_chunks[i]) {
-            ofs_cpp << "    map[\"" << escape_cpp_string(kv.first) << "\"] = \"" << escape_cpp_string(kv.second) << "\";\n";
+    write_string_map(ofs_cpp, "CONFUSABLE_TO_CANONICAL_FOLDED", "confusable_to_canonical_folded", confusable_to_canonical_folded, CHUNK_SIZE);
+
+    // Worst-case UTF-8 growth per input byte over both tables, so callers can size output buffers up front.
+    // Starts at 3 because an ill-formed single byte decodes to U+FFFD (3 bytes).
+    size_t max_expansion = 3;
+    for (const auto* table : {&confusable_to_canonical, &confusable_to_canonical_folded}) {
+        for (const auto& kv : *table) {
+            size_t ratio = (kv.second.size() + kv.first.size() - 1) / kv.first.size();
+            if (ratio > max_expansion) max_expansion = ratio;
         }
-        ofs_cpp << "}\n\n";
     }
+    ofs_header << "// Upper bound on normalized UTF-8 bytes per input byte, for either table\n";
+    ofs_header << "constexpr size_t CONFUSABLE_MAX_EXPANSION = " << max_expansion << ";\n\n";
     
-    // Generate the main map with runtime initialization
-    ofs_cpp << "const std::unordered_map<std::string, std::string> CONFUSABLE_TO_CANONICAL = []() {\n";
-    ofs_cpp << "    std::unordered_map<std::string, std::string> map;\n";
-    ofs_cpp << "    map.reserve(" << count1 << ");\n";
-    for (size_t i = 0; i < confusable_chunks.size(); ++i) {
-        ofs_cpp << "    init_confusable_to_canonical_chunk_" << i << "(map);\n";
-    }
-    ofs_cpp << "    return map;\n";
-    ofs_cpp << "}();\n\n";
-    
-    // Generate initialization functions for CONFUSABLES_MAP
-    std::vector<std::vector<std::pair<std::string, std::unordered_set<std::string>>>> confusables_map_chunks;
-    auto it2 = canonical_to_confusables.begin();
-    while (it2 != canonical_to_confusables.end()) {
-        confusables_map_chunks.emplace_back();
-        for (size_t i = 0; i < CHUNK_SIZE && it2 != canonical_to_confusables.end(); ++i, ++it2) {
-            confusables_map_chunks.back().emplace_back(it2->first, it2->second);
-        }
+    if (!write_script_sets(ofs_header, ofs_cpp))
+    {
+        return 1;
     }
-    
-    // Generate chunk initialization functions for CONFUSABLES_MAP
-    for (size_t i = 0; i < confusables_map_chunks.size(); ++i) {
-        ofs_cpp << "static void init_confusables_map_chunk_" << i << "(std::unordered_map<std::string, std::unordered_set<std::string>>& map) {\n";
-        for (const auto& kv : confusables_map_chunks[i]) {
-            ofs_cpp << "    map[\"" << escape_cpp_string(kv.first) << "\"] = { ";
-            bool first = true;
-            for (const std::string& s : kv.second) {
-                if (!first) ofs_cpp << ", ";
-                ofs_cpp << "\"" << escape_cpp_string(s) << "\"";
-                first = false;
-            }
-            ofs_cpp << " };\n";
+
+    if (argc == 5)
+    {
+        std::ofstream ofs_constexpr(argv[4]);
+        if (!ofs_constexpr)
+        {
+            std::cerr << "Failed to open output constexpr header for writing\n";
+            return 1;
         }
-        ofs_cpp << "}\n\n";
-    }
-    
-    // Generate the main CONFUSABLES_MAP with runtime initialization
-    ofs_cpp << "const std::unordered_map<std::string, std::unordered_set<std::string>> CONFUSABLES_MAP = []() {\n";
-    ofs_cpp << "    std::unordered_map<std::string, std::unordered_set<std::string>> map;\n";
-    ofs_cpp << "    map.reserve(" << canonical_to_confusables.size() << ");\n";
-    for (size_t i = 0; i < confusables_map_chunks.size(); ++i) {
-        ofs_cpp << "    init_confusables_map_chunk_" << i << "(map);\n";
+        write_constexpr_tables(ofs_constexpr, input_file, {
+            {"CONFUSABLE_TO_CANONICAL", &confusable_to_canonical},
+            {"CONFUSABLE_TO_CANONICAL_FOLDED", &confusable_to_canonical_folded},
+        });
     }
-    ofs_cpp << "    return map;\n";
-    ofs_cpp << "}();\n\n";
-    
+
+    ofs_header << "} // namespace unicode_confusables\n";
     ofs_cpp << "} // namespace unicode_confusables\n";
-    ofs_cpp << "// Confusable->Canonical entries: " << count1 << ", Canonical->Confusables entries: " << count2 << "\n";
-    std::cout << "Files generated: " << output_header << " and " << output_cpp << " with " << count1 << " confusable mappings and " << count2 << " confusable entries.\n";
+    ofs_cpp << "// Confusable->Canonical entries: " << count1 << ", folded entries: " << confusable_to_canonical_folded.size() << "\n";
+    std::cout << "Files generated: " << output_header << " and " << output_cpp << " with " << count1 << " confusable mappings and " << confusable_to_canonical_folded.size() << " folded mappings.\n";
     return 0;
 }